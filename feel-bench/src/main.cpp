@@ -0,0 +1,695 @@
+#include "feel/Feel.hpp"
+#include "feel/HandManager.hpp"
+#include "feel/SimulatorDevice.hpp"
+#include "feel/RecordingDevice.hpp"
+#include "feel/ReplayDevice.hpp"
+#include "feel/MessageQueue.hpp"
+#include "feel/RingBuffer.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Every allocation of the process is counted, so the benchmarks can
+// report how many allocations an operation needs.
+static std::atomic<std::uint64_t> allocationCount{ 0 };
+
+void* operator new(std::size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) return memory;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+// GCC inlines the replaced operator new into its callers and then takes the
+// std::free() below for a mismatch, although every allocation here is malloc'ed.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Result
+    {
+        std::string name;
+        std::uint64_t operations;
+        double nanosecondsPerOperation;
+        double messagesPerSecond;
+        double allocationsPerOperation;
+    };
+
+    std::string filter;
+    std::chrono::milliseconds minimumDuration(200);
+
+    void Report(const std::string& name, std::uint64_t operations, std::uint64_t messages, Clock::duration elapsed, std::uint64_t allocations)
+    {
+        double seconds = std::chrono::duration<double>(elapsed).count();
+        Result result;
+        result.name = name;
+        result.operations = operations;
+        result.nanosecondsPerOperation = seconds * 1e9 / operations;
+        result.messagesPerSecond = messages / seconds;
+        result.allocationsPerOperation = double(allocations) / operations;
+        std::cout
+            << std::left << std::setw(40) << result.name << std::right
+            << std::setw(12) << result.operations
+            << std::setw(14) << std::fixed << std::setprecision(1) << result.nanosecondsPerOperation
+            << std::setw(16) << std::setprecision(0) << result.messagesPerSecond
+            << std::setw(12) << std::setprecision(3) << result.allocationsPerOperation
+            << std::endl;
+    }
+
+    bool Selected(const std::string& name)
+    {
+        return filter.empty() || name.find(filter) != std::string::npos;
+    }
+
+    /// Calls operation(iterations) with a growing count until it ran
+    /// long enough. Every iteration counts as operationsPerIteration
+    /// operations and messagesPerIteration messages.
+    template<typename Operation>
+    void Run(const std::string& name, std::uint64_t operationsPerIteration, std::uint64_t messagesPerIteration, Operation&& operation)
+    {
+        if (!Selected(name)) return;
+        operation(std::uint64_t(16));
+        std::uint64_t iterations = 16;
+        while (true)
+        {
+            std::uint64_t allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+            auto start = Clock::now();
+            operation(iterations);
+            auto elapsed = Clock::now() - start;
+            std::uint64_t allocations = allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+            if (elapsed >= minimumDuration || iterations >= (std::uint64_t(1) << 40))
+            {
+                Report(name, iterations * operationsPerIteration, iterations * messagesPerIteration, elapsed, allocations);
+                return;
+            }
+            iterations *= 2;
+        }
+    }
+
+    /// A device without hardware: replays a fixed set of messages on
+    /// every ParseMessages() and swallows everything sent to it.
+    class BenchDevice : public feel::Device
+    {
+    public:
+        std::uint64_t transmitted = 0;
+
+        void SetReplay(const std::vector<std::string>& messages)
+        {
+            storage = messages;
+            replay.clear();
+            for (const std::string& message : storage)
+            {
+                replay.push_back(feel::ReceivedMessage{ message.data(), message.size(), Clock::time_point() });
+            }
+        }
+
+        feel::DeviceStatus GetStatus() override
+        {
+            return feel::DeviceStatus::Connected;
+        }
+
+        void Connect(const char* /*deviceName*/) override {}
+        void Disconnect() override {}
+
+        void GetAvailableDevices(std::vector<std::string>& devices) override
+        {
+            devices.emplace_back("Bench");
+        }
+
+        void TransmitMessage(std::string /*identifier*/, std::string /*payload*/ = "") override
+        {
+            transmitted++;
+        }
+
+        void TransmitMessage(const feel::CommandBuffer& /*command*/) override
+        {
+            transmitted++;
+        }
+
+        void TransmitMessages(const feel::CommandBuffer* /*commands*/, std::size_t count) override
+        {
+            transmitted += count;
+        }
+
+        void IterateAllMessages(std::function<void(const std::string&)> callback) override
+        {
+            for (const std::string& message : storage)
+            {
+                callback(message);
+            }
+        }
+
+        void IterateReceivedMessages(std::function<void(const feel::ReceivedMessage&)> callback) override
+        {
+            // Every batch is received one millisecond after the previous one
+            now += std::chrono::milliseconds(1);
+            for (feel::ReceivedMessage& message : replay)
+            {
+                message.timestamp = now;
+                callback(message);
+            }
+        }
+
+        void DrainMessages(feel::MessageBatch& batch) override
+        {
+            batch.Clear();
+            now += std::chrono::milliseconds(1);
+            for (feel::ReceivedMessage& message : replay)
+            {
+                message.timestamp = now;
+                batch.AppendView(message);
+            }
+        }
+
+    private:
+        std::vector<std::string> storage;
+        std::vector<feel::ReceivedMessage> replay;
+        Clock::time_point now;
+    };
+
+    std::string Hex2(int value)
+    {
+        static const char digits[] = "0123456789abcdef";
+        return std::string{ digits[(value >> 4) & 0xf], digits[value & 0xf] };
+    }
+
+    std::string Decimal3(int value)
+    {
+        std::string text = std::to_string(value);
+        return std::string(3 - text.size(), '0') + text;
+    }
+
+    std::string FingerUpdate(int finger, int angle)
+    {
+        return "UF" + Hex2(finger) + Decimal3(angle);
+    }
+
+    std::string NormalizationData(int finger, int realAngle, int angle)
+    {
+        return "NI" + Hex2(finger) + Decimal3(realAngle) + std::to_string(angle);
+    }
+
+    void BenchmarkParse(const std::string& name, const std::vector<std::string>& messages)
+    {
+        BenchDevice* device = new BenchDevice();
+        device->SetReplay(messages);
+        feel::Feel feel(device);
+        feel.SetDebugLogCallback([](std::string) {});
+        Run(name, messages.size(), messages.size(), [&](std::uint64_t iterations)
+        {
+            for (std::uint64_t i = 0; i < iterations; i++)
+            {
+                feel.ParseMessages();
+            }
+        });
+    }
+
+    void ParseBenchmarks()
+    {
+        std::vector<std::string> updates;
+        for (int i = 0; i < feel::FINGER_TYPE_COUNT; i++)
+        {
+            updates.push_back(FingerUpdate(i, 40 + 10 * i));
+        }
+        BenchmarkParse("parse UF (10 per frame)", updates);
+
+        std::vector<std::string> normalization;
+        for (int i = 0; i < feel::FINGER_TYPE_COUNT; i++)
+        {
+            normalization.push_back(NormalizationData(i, 90, 200 + i));
+        }
+        BenchmarkParse("parse NI", normalization);
+
+        // A whole normalization in 10 messages instead of 1810
+        std::vector<std::string> sweeps;
+        for (int i = 0; i < feel::FINGER_TYPE_COUNT; i++)
+        {
+            std::array<int, 181> angles;
+            for (int a = 0; a <= 180; a++)
+            {
+                angles[a] = 100 + 2 * a + i;
+            }
+            char message[feel::NormalizationSweep::HEADER_SIZE + 181 * feel::NormalizationSweep::SAMPLE_WIDTH];
+            sweeps.emplace_back(message, feel::NormalizationSweep::Encode(i, 0, angles.data(), angles.size(), message));
+        }
+        BenchmarkParse("parse NB (181 samples per message)", sweeps);
+
+        std::vector<std::string> mix = updates;
+        mix.push_back(NormalizationData(3, 45, 120));
+        mix.push_back(NormalizationData(4, 46, 121));
+        mix.push_back("DLForce sensor 3 reports an unexpected value");
+        BenchmarkParse("parse mix (10 UF, 2 NI, 1 DL)", mix);
+    }
+
+    void EncodeBenchmarks()
+    {
+        BenchDevice* device = new BenchDevice();
+        feel::Feel feel(device);
+
+        // Alternate the angle, otherwise unchanged targets are not sent at all
+        Run("encode SetFingerAngle", 1, 1, [&](std::uint64_t iterations)
+        {
+            for (std::uint64_t i = 0; i < iterations; i++)
+            {
+                feel.SetFingerAngle(static_cast<feel::Finger>(i % feel::FINGER_TYPE_COUNT), 90.0f + (i / feel::FINGER_TYPE_COUNT) % 2, 50);
+            }
+        });
+
+        Run("encode SetFingerAngle + ReleaseFinger", 2, 2, [&](std::uint64_t iterations)
+        {
+            for (std::uint64_t i = 0; i < iterations; i++)
+            {
+                feel::Finger finger = static_cast<feel::Finger>(i % feel::FINGER_TYPE_COUNT);
+                feel.SetFingerAngle(finger, 90.0f, 50);
+                feel.ReleaseFinger(finger);
+            }
+        });
+
+        std::array<feel::FingerTarget, feel::FINGER_TYPE_COUNT> targets;
+        Run("encode SetFingerTargets (10 fingers)", 1, feel::FINGER_TYPE_COUNT, [&](std::uint64_t iterations)
+        {
+            for (std::uint64_t i = 0; i < iterations; i++)
+            {
+                for (int f = 0; f < feel::FINGER_TYPE_COUNT; f++)
+                {
+                    targets[f] = feel::FingerTarget::Move(static_cast<feel::Finger>(f), 90.0f + i % 2, 50);
+                }
+                feel.SetFingerTargets(targets.data(), targets.size());
+            }
+        });
+    }
+
+    // Extrapolating every finger one display frame past its latest sample
+    void PredictionBenchmark(const std::string& name, const feel::PredictionSettings& settings)
+    {
+        std::vector<std::string> updates;
+        for (int i = 0; i < feel::FINGER_TYPE_COUNT; i++)
+        {
+            updates.push_back(FingerUpdate(i, 40 + 10 * i));
+        }
+        BenchDevice* device = new BenchDevice();
+        device->SetReplay(updates);
+        feel::Feel feel(device);
+        feel.SetPrediction(settings);
+        for (int i = 0; i < 8; i++)
+        {
+            feel.ParseMessages();
+        }
+        // One display frame ahead of the latest sample
+        auto target = feel.GetLatestFingerSample(feel::HAND_0_THUMB_0).timestamp + std::chrono::milliseconds(16);
+        Run(name, 1, feel::FINGER_TYPE_COUNT, [&](std::uint64_t iterations)
+        {
+            for (std::uint64_t i = 0; i < iterations; i++)
+            {
+                for (int f = 0; f < feel::FINGER_TYPE_COUNT; f++)
+                {
+                    feel.GetPredictedFingerAngle(static_cast<feel::Finger>(f), target);
+                }
+            }
+        });
+    }
+
+    void PredictionBenchmarks()
+    {
+        PredictionBenchmark("predict velocity (10 fingers)", feel::PredictionSettings::ConstantVelocity());
+        PredictionBenchmark("predict acceleration (10 fingers)", feel::PredictionSettings::ConstantAcceleration());
+        PredictionBenchmark("predict Kalman (10 fingers)", feel::PredictionSettings::Kalman(1.0e6f, 1.0f));
+    }
+
+    // The queues SimulatorDevice (and the serial devices) hand messages through
+    void QueueBenchmarks()
+    {
+        const std::string update = FingerUpdate(3, 123);
+        const std::string debug = "DLForce sensor 3 reports an unexpected value";
+
+        {
+            feel::MessageQueue queue;
+            auto timestamp = Clock::now();
+            Run("queue MessageQueue push+drain (UF)", 1, 1, [&](std::uint64_t iterations)
+            {
+                std::size_t received = 0;
+                for (std::uint64_t i = 0; i < iterations; i++)
+                {
+                    queue.TryPush(update.data(), update.size(), timestamp);
+                    if (i % 64 == 63)
+                    {
+                        queue.Drain([&](const feel::ReceivedMessage& message) { received += message.length; });
+                    }
+                }
+                queue.Drain([&](const feel::ReceivedMessage& message) { received += message.length; });
+            });
+
+            Run("queue MessageQueue push+drain (DL)", 1, 1, [&](std::uint64_t iterations)
+            {
+                std::size_t received = 0;
+                for (std::uint64_t i = 0; i < iterations; i++)
+                {
+                    queue.TryPush(debug.data(), debug.size(), timestamp);
+                    if (i % 64 == 63)
+                    {
+                        queue.Drain([&](const feel::ReceivedMessage& message) { received += message.length; });
+                    }
+                }
+                queue.Drain([&](const feel::ReceivedMessage& message) { received += message.length; });
+            });
+        }
+
+        {
+            // The receiving thread pushes, the application drains
+            feel::MessageQueue queue;
+            Run("queue MessageQueue cross-thread (UF)", 1, 1, [&](std::uint64_t iterations)
+            {
+                std::thread producer([&]()
+                {
+                    auto timestamp = Clock::now();
+                    for (std::uint64_t i = 0; i < iterations; i++)
+                    {
+                        while (!queue.TryPush(update.data(), update.size(), timestamp))
+                        {
+                            std::this_thread::yield();
+                        }
+                    }
+                });
+                std::uint64_t received = 0;
+                while (received < iterations)
+                {
+                    queue.Drain([&](const feel::ReceivedMessage&) { received++; });
+                }
+                producer.join();
+            });
+        }
+
+        {
+            feel::RingBuffer<feel::CommandBuffer, 256> ring;
+            feel::CommandBuffer command = feel::CommandBuffer::WriteFinger(3, 50, 90);
+            Run("queue RingBuffer<CommandBuffer> push+pop", 1, 1, [&](std::uint64_t iterations)
+            {
+                feel::CommandBuffer popped;
+                for (std::uint64_t i = 0; i < iterations; i++)
+                {
+                    ring.TryPush(command);
+                    ring.TryPop(popped);
+                }
+            });
+        }
+    }
+
+    // Runs the normalization, advance() lets the simulator make progress
+    template<typename Advance>
+    void Normalize(feel::Feel& feel, Advance&& advance)
+    {
+        feel.SetDebugLogCallback([](std::string) {});
+        feel.Connect("Simulator");
+        feel.StartNormalization();
+        while (feel.GetStatus() == feel::FeelStatus::Normalization)
+        {
+            advance();
+            feel.ParseMessages();
+        }
+        feel.BeginSession();
+    }
+
+    // What a typical application does every frame
+    void UpdateTargets(feel::Feel& feel, std::array<feel::FingerTarget, feel::FINGER_TYPE_COUNT>& targets)
+    {
+        for (int f = 0; f < feel::FINGER_TYPE_COUNT; f++)
+        {
+            feel::Finger finger = static_cast<feel::Finger>(f);
+            float angle = feel.GetFingerAngle(finger);
+            targets[f] = angle < 90 ? feel::FingerTarget::Move(finger, 120, 60) : feel::FingerTarget::Release(finger);
+        }
+        feel.SetFingerTargets(targets.data(), targets.size());
+    }
+
+    // A whole session against the simulator in real time, only the
+    // application side of every frame is measured.
+    void RealTimeSessionBenchmark()
+    {
+        const std::string name = "session simulator frame";
+        if (!Selected(name)) return;
+
+        feel::Feel feel(new feel::SimulatorDevice());
+        Normalize(feel, []() { std::this_thread::sleep_for(std::chrono::milliseconds(1)); });
+        std::uint64_t messages = 0;
+        feel.SetFingerUpdateHandler([&](feel::Finger, const feel::FingerSample&) { messages++; });
+
+        const std::uint64_t frames = 120;
+        std::array<feel::FingerTarget, feel::FINGER_TYPE_COUNT> targets;
+        Clock::duration busy(0);
+        std::uint64_t allocations = 0;
+        for (std::uint64_t frame = 0; frame < frames; frame++)
+        {
+            std::uint64_t allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+            auto start = Clock::now();
+            feel.ParseMessages();
+            UpdateTargets(feel, targets);
+            busy += Clock::now() - start;
+            allocations += allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+            std::this_thread::sleep_for(std::chrono::milliseconds(16));
+        }
+        feel.EndSession();
+        feel.Disconnect();
+        Report(name, frames, messages, busy, allocations);
+    }
+
+    // Simulator and application on one thread, one tick per frame
+    void SteppedSessionBenchmark()
+    {
+        feel::SimulatorSettings settings;
+        settings.mode = feel::SimulationMode::Stepped;
+        settings.tickRate = 1000;
+        feel::SimulatorDevice* device = new feel::SimulatorDevice(settings);
+        feel::Feel feel(device);
+        Normalize(feel, [&]() { device->Step(); });
+
+        std::array<feel::FingerTarget, feel::FINGER_TYPE_COUNT> targets;
+        Run("session simulator stepped tick", 1, feel::FINGER_TYPE_COUNT, [&](std::uint64_t iterations)
+        {
+            for (std::uint64_t i = 0; i < iterations; i++)
+            {
+                device->Step();
+                feel.ParseMessages();
+                UpdateTargets(feel, targets);
+            }
+        });
+    }
+
+    // Several stepped simulators behind one HandManager, one tick of every hand per frame
+    void HandManagerBenchmark(std::size_t handCount)
+    {
+        feel::SimulatorSettings settings;
+        settings.mode = feel::SimulationMode::Stepped;
+        settings.tickRate = 1000;
+        feel::HandManager manager;
+        manager.SetDebugLogCallback([](std::size_t, std::string) {});
+        std::vector<feel::SimulatorDevice*> devices;
+        for (std::size_t hand = 0; hand < handCount; hand++)
+        {
+            devices.push_back(new feel::SimulatorDevice(settings));
+            manager.AddHand(devices.back());
+            manager.Connect(hand, "Simulator");
+            manager.StartNormalization(hand);
+        }
+        for (int tick = 0; tick < 2; tick++)
+        {
+            for (feel::SimulatorDevice* device : devices) device->Step();
+            manager.ParseMessages();
+        }
+        for (std::size_t hand = 0; hand < handCount; hand++)
+        {
+            manager.BeginSession(hand);
+        }
+
+        Run("hands " + std::to_string(handCount) + " stepped tick", 1, handCount * feel::FINGER_TYPE_COUNT, [&](std::uint64_t iterations)
+        {
+            for (std::uint64_t i = 0; i < iterations; i++)
+            {
+                for (feel::SimulatorDevice* device : devices) device->Step();
+                manager.ParseMessages();
+            }
+        });
+    }
+
+    // The simulator thread runs as fast as the application consumes
+    void FreeRunningSessionBenchmark()
+    {
+        feel::SimulatorSettings settings;
+        settings.mode = feel::SimulationMode::FreeRunning;
+        settings.tickRate = 1000;
+        feel::SimulatorDevice* device = new feel::SimulatorDevice(settings);
+        feel::Feel feel(device);
+        Normalize(feel, []() { std::this_thread::yield(); });
+
+        Run("session simulator free-running tick", 1, feel::FINGER_TYPE_COUNT, [&](std::uint64_t iterations)
+        {
+            std::uint64_t target = device->GetTickCount() + iterations;
+            while (device->GetTickCount() < target)
+            {
+                feel.ParseMessages();
+            }
+        });
+    }
+
+    // Records a session of a stepped simulator, gives a capture to replay without hardware
+    bool RecordSimulatorCapture(const std::string& fileName, std::uint64_t ticks)
+    {
+        feel::SimulatorSettings settings;
+        settings.mode = feel::SimulationMode::Stepped;
+        settings.tickRate = 1000;
+        feel::SimulatorDevice* simulator = new feel::SimulatorDevice(settings);
+        feel::RecordingDevice* recorder = new feel::RecordingDevice(simulator);
+        feel::Feel feel(recorder);
+        if (!recorder->StartRecording(fileName.c_str()))
+        {
+            std::cout << "Cannot create " << fileName << std::endl;
+            return false;
+        }
+        Normalize(feel, [&]() { simulator->Step(); });
+        std::array<feel::FingerTarget, feel::FINGER_TYPE_COUNT> targets;
+        for (std::uint64_t i = 0; i < ticks; i++)
+        {
+            simulator->Step();
+            feel.ParseMessages();
+            UpdateTargets(feel, targets);
+        }
+        feel.EndSession();
+        feel.Disconnect();
+        recorder->StopRecording();
+        return true;
+    }
+
+    // Feel::ParseMessages() over a whole capture, played as fast as possible
+    void ReplayBenchmark(const std::string& fileName)
+    {
+        const std::string name = "replay " + fileName;
+        if (!Selected(name)) return;
+
+        feel::ReplaySettings settings;
+        settings.speed = 0;
+        feel::ReplayDevice* device = new feel::ReplayDevice(settings);
+        feel::Feel feel(device);
+        feel.SetDebugLogCallback([](std::string) {});
+        feel.Connect(fileName.c_str());
+        if (device->GetStatus() != feel::DeviceStatus::Connected) return;
+
+        // Played at least once and until it ran long enough
+        std::uint64_t calls = 0;
+        std::uint64_t allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+        auto start = Clock::now();
+        while (true)
+        {
+            feel.ParseMessages();
+            calls++;
+            if (!device->Finished()) continue;
+            if (Clock::now() - start >= minimumDuration) break;
+            device->Restart();
+        }
+        auto elapsed = Clock::now() - start;
+        std::uint64_t allocations = allocationCount.load(std::memory_order_relaxed) - allocationsBefore;
+        std::uint64_t messages = device->GetReplayedCount();
+        if (messages == 0)
+        {
+            std::cout << name << ": no messages received in the capture" << std::endl;
+            return;
+        }
+        Report(name, messages, messages, elapsed, allocations);
+        std::cout << "  " << calls << " ParseMessages() calls" << std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string replayFile;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string argument = argv[i];
+        if (argument == "--quick")
+        {
+            minimumDuration = std::chrono::milliseconds(20);
+        }
+        else if (argument == "--replay" && i + 1 < argc)
+        {
+            replayFile = argv[++i];
+        }
+        else if (argument == "--record-simulator" && i + 2 < argc)
+        {
+            std::string fileName = argv[++i];
+            return RecordSimulatorCapture(fileName, std::strtoull(argv[++i], nullptr, 10)) ? 0 : 1;
+        }
+        else if (argument == "--help")
+        {
+            std::cout
+                << "Usage: feel-bench [--quick] [--replay capture] [name filter]" << std::endl
+                << "       feel-bench --record-simulator capture ticks" << std::endl;
+            return 0;
+        }
+        else
+        {
+            filter = argument;
+        }
+    }
+
+    std::cout
+        << std::left << std::setw(40) << "benchmark" << std::right
+        << std::setw(12) << "ops"
+        << std::setw(14) << "ns/op"
+        << std::setw(16) << "msgs/s"
+        << std::setw(12) << "allocs/op"
+        << std::endl;
+
+    ParseBenchmarks();
+    EncodeBenchmarks();
+    PredictionBenchmarks();
+    QueueBenchmarks();
+    RealTimeSessionBenchmark();
+    SteppedSessionBenchmark();
+    FreeRunningSessionBenchmark();
+    HandManagerBenchmark(2);
+    HandManagerBenchmark(8);
+    if (!replayFile.empty())
+    {
+        ReplayBenchmark(replayFile);
+    }
+    return 0;
+}
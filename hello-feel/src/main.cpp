@@ -2,10 +2,18 @@
 #include <chrono>
 #include <iostream>
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#ifdef _WIN32
 #include <Windows.h>
+#else
+#include <csignal>
+#endif
 
 
 static std::atomic_flag keepRunning;
+#ifdef _WIN32
 BOOL WINAPI ConsoleCtrlHandler(DWORD dwCtrlType)
 {
     switch (dwCtrlType)
@@ -17,10 +25,31 @@ BOOL WINAPI ConsoleCtrlHandler(DWORD dwCtrlType)
         default: return FALSE;
     }
 }
+#else
+void SignalHandler(int)
+{
+    keepRunning.clear();
+}
+#endif
 
-int main()
+int main(int argc, char** argv)
 {
-	feel::Feel feel(new feel::SerialDevice());
+#ifdef _WIN32
+	feel::Device* device = new feel::SerialDevice();
+#else
+    feel::Device* device = new feel::PosixSerialDevice();
+#endif
+    // hello-feel --record capture.bin records the session, play it back with feel::ReplayDevice
+    if (argc > 2 && std::string(argv[1]) == "--record")
+    {
+        feel::RecordingDevice* recorder = new feel::RecordingDevice(device);
+        if (!recorder->StartRecording(argv[2]))
+        {
+            std::cout << "Cannot create " << argv[2] << std::endl;
+        }
+        device = recorder;
+    }
+    feel::Feel feel(device);
     //feel::Feel feel(new feel::SimulatorDevice());
 
     auto devices = feel.GetAvailableDevices();
@@ -39,43 +68,97 @@ int main()
 	feel.Connect(devices[0].c_str());
 
     keepRunning.test_and_set();
+#ifdef _WIN32
     SetConsoleCtrlHandler(&ConsoleCtrlHandler, TRUE);
-
-    feel.StartNormalization();
-    while (feel.GetStatus() == feel::FeelStatus::Normalization)
+#else
+    std::signal(SIGINT, &SignalHandler);
+    std::signal(SIGTERM, &SignalHandler);
+#endif
+
+    // Let the messages be processed as they arrive instead of once per frame
+    bool polling = !feel.SetDispatchMode(feel::DispatchMode::DispatchThread);
+
+    // Start right away with the calibration stored for this glove, as long as it still fits
+    const char* calibrationFile = "feel-calibration.txt";
+    feel::CalibrationStore calibrationStore;
+    feel::CalibrationData calibration;
+    bool calibrated = false;
+    if (calibrationStore.Load(calibrationFile) && calibrationStore.Find(feel.GetDeviceIdentifier(), calibration))
     {
-        if (!keepRunning.test_and_set())
+        feel.SetCalibrationData(calibration);
+        feel.BeginSession();
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+        feel::CalibrationCheck check = feel::CalibrationCheck::Pending;
+        while (check == feel::CalibrationCheck::Pending && std::chrono::steady_clock::now() < deadline)
         {
-            feel.Disconnect();
-            return 0;
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            if (polling) feel.ParseMessages();
+            check = feel.CheckCalibration();
+        }
+        calibrated = check == feel::CalibrationCheck::Valid;
+        if (!calibrated)
+        {
+            std::cout << "Stored calibration does not fit, normalizing again" << std::endl;
+            feel.EndSession();
         }
-        std::cout << "Normalization Frame" << std::endl;
-        feel.ParseMessages();
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
 
-	feel.BeginSession();
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    feel.ParseMessages();
-    std::array<bool, feel::FINGER_TYPE_COUNT> fingerBelow;
-    std::array<std::array<float, 10>, feel::FINGER_TYPE_COUNT> lastPositions;
-
-    for (int i = 0; i < feel::FINGER_TYPE_COUNT; i++)
+    if (!calibrated)
     {
-        feel::Finger finger = static_cast<feel::Finger>(i);
-        lastPositions[i].fill(feel.GetFingerAngle(finger));
+        std::mutex normalizationMutex;
+        std::condition_variable normalizationEnded;
+        feel.SetEndNormalizationHandler([&]()
+        {
+            std::lock_guard<std::mutex> lock(normalizationMutex);
+            normalizationEnded.notify_all();
+        });
+
+        feel.StartNormalization();
+        {
+            std::unique_lock<std::mutex> lock(normalizationMutex);
+            while (feel.GetStatus() == feel::FeelStatus::Normalization)
+            {
+                if (!keepRunning.test_and_set())
+                {
+                    lock.unlock();
+                    feel.Disconnect();
+                    return 0;
+                }
+                if (polling)
+                {
+                    lock.unlock();
+                    feel.ParseMessages();
+                    lock.lock();
+                }
+                // Still wakes up regularly to notice Ctrl+C
+                normalizationEnded.wait_for(lock, std::chrono::milliseconds(100));
+            }
+        }
+        feel.SetEndNormalizationHandler(nullptr);
+
+        calibrationStore.Store(feel.GetDeviceIdentifier(), feel.GetCalibrationData());
+        if (!calibrationStore.Save(calibrationFile))
+        {
+            std::cout << "Cannot save " << calibrationFile << std::endl;
+        }
+
+        feel.BeginSession();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (polling) feel.ParseMessages();
     }
+    std::array<bool, feel::FINGER_TYPE_COUNT> fingerBelow;
 
 	while (keepRunning.test_and_set())
 	{
 		std::cout << "Process Frame" << std::endl;
-        feel.ParseMessages();
+        if (polling) feel.ParseMessages();
+        std::array<feel::FingerTarget, feel::FINGER_TYPE_COUNT> targets;
 
         for (int i = 0; i < feel::FINGER_TYPE_COUNT; i++)
         {
             feel::Finger finger = static_cast<feel::Finger>(i);
             float angle = feel.GetFingerAngle(finger);
-            float velocity = (angle - lastPositions[i][0]) * 10 * 0.016f;
+            float velocity = feel.GetFingerVelocity(finger);
             std::cout << "Finger " << i << ": " << angle
                 << " Velocity " << velocity;
 
@@ -84,35 +167,32 @@ int main()
             float force;
             if (fingerBelow[i] && angle > midAngle - 5 && angle + 5 < midAngle && velocity > 0)
             {
-                feel.ReleaseFinger(finger);
+                targets[i] = feel::FingerTarget::Release(finger);
                 released = true;
             }
-            else if (angle < midAngle - 10 && velocity < -1)
+            else if (angle < midAngle - 10 && velocity < -40)
             {
                 force = 99;
-                feel.SetFingerAngle(finger, 180, force);
+                targets[i] = feel::FingerTarget::Move(finger, 180, force);
                 fingerBelow[i] = true;
             }
-            else if (angle < midAngle && std::abs(velocity) > 0.5f)
+            else if (angle < midAngle && std::abs(velocity) > 20)
             {
                 force = 40;
-                feel.SetFingerAngle(finger, midAngle + (midAngle - angle), force);
+                targets[i] = feel::FingerTarget::Move(finger, midAngle + (midAngle - angle), force);
                 fingerBelow[i] = true;
             }
             else
             {
-                feel.ReleaseFinger(finger);
+                targets[i] = feel::FingerTarget::Release(finger);
                 fingerBelow[i] = false;
                 released = true;
             }
 
             if (!released) std::cout << " Force " << force;
             std::cout << std::endl;
-
-            std::rotate(lastPositions[i].begin(), lastPositions[i].begin() + 1, lastPositions[i].end());
-            lastPositions[i][9] = angle;
-
         }
+        feel.SetFingerTargets(targets.data(), targets.size());
 
 		std::this_thread::sleep_for(std::chrono::milliseconds(16));
 	}
@@ -1,5 +1,13 @@
 #pragma once
 
 #include "feel/Feel.hpp"
+#include "feel/HandManager.hpp"
+#include "feel/CalibrationStore.hpp"
+#ifdef _WIN32
 #include "feel/SerialDevice.hpp"
-#include "feel/SimulatorDevice.hpp"
\ No newline at end of file
+#elif defined(__linux__)
+#include "feel/PosixSerialDevice.hpp"
+#endif
+#include "feel/SimulatorDevice.hpp"
+#include "feel/RecordingDevice.hpp"
+#include "feel/ReplayDevice.hpp"
\ No newline at end of file
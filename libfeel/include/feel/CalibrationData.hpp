@@ -13,5 +13,16 @@ namespace feel
     {
         std::array<FingerCalibrationData, FINGER_TYPE_COUNT> angles;
     };
+
+    /// @brief The result of Feel::CheckCalibration()
+    enum class CalibrationCheck
+    {
+        /// @brief Not every finger sent enough samples yet
+        Pending,
+        /// @brief All samples lie within the calibrated ranges
+        Valid,
+        /// @brief A sample lies outside of the calibrated range, normalize again
+        Invalid
+    };
 }
 
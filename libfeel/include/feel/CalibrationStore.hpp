@@ -0,0 +1,126 @@
+#pragma once
+#include "feel/Finger.hpp"
+#include "feel/CalibrationData.hpp"
+#include <cstdio>
+#include <map>
+#include <string>
+
+namespace feel
+{
+    /// @brief Calibration data of several gloves, saved to and loaded from a file
+    ///
+    /// Profiles are keyed by the device identifier (see Feel::GetDeviceIdentifier()),
+    /// so a program can call SetCalibrationData() with the profile of the connected
+    /// glove instead of running StartNormalization() every time.
+    ///
+    /// The file is plain text, a version line followed by one line per glove:
+    /// the identifier, a tab and the min and max of every finger.
+    class CalibrationStore
+    {
+    public:
+        static constexpr int VERSION = 1;
+
+        /// @brief Replace the profiles with the ones in the file
+        /// @return false if the file does not exist or has another version,
+        /// the store is empty then. Malformed lines are skipped.
+        bool Load(const char* fileName)
+        {
+            profiles.clear();
+            std::FILE* file = std::fopen(fileName, "r");
+            if (file == nullptr) return false;
+            int version = 0;
+            bool valid = std::fscanf(file, "feel-calibration %d\n", &version) == 1 && version == VERSION;
+            char line[1024];
+            while (valid && std::fgets(line, sizeof(line), file) != nullptr)
+            {
+                ParseLine(line);
+            }
+            std::fclose(file);
+            return valid;
+        }
+
+        /// @brief Write all profiles to the file, replacing it
+        /// @return false if the file could not be written
+        bool Save(const char* fileName) const
+        {
+            std::FILE* file = std::fopen(fileName, "w");
+            if (file == nullptr) return false;
+            std::fprintf(file, "feel-calibration %d\n", VERSION);
+            for (const auto& profile : profiles)
+            {
+                std::fprintf(file, "%s\t", profile.first.c_str());
+                for (const FingerCalibrationData& finger : profile.second.angles)
+                {
+                    std::fprintf(file, " %d %d", finger.min, finger.max);
+                }
+                std::fprintf(file, "\n");
+            }
+            bool written = !std::ferror(file);
+            return std::fclose(file) == 0 && written;
+        }
+
+        /// @brief Get the profile of a device
+        /// @return false if there is none
+        bool Find(const std::string& deviceIdentifier, CalibrationData& data) const
+        {
+            auto profile = profiles.find(deviceIdentifier);
+            if (profile == profiles.end()) return false;
+            data = profile->second;
+            return true;
+        }
+
+        /// @brief Add or replace the profile of a device
+        /// @return false if the data is not usable (see IsUsable()), nothing is stored then
+        bool Store(const std::string& deviceIdentifier, const CalibrationData& data)
+        {
+            if (!IsUsable(data) || !IsValidIdentifier(deviceIdentifier)) return false;
+            profiles[deviceIdentifier] = data;
+            return true;
+        }
+
+        void Remove(const std::string& deviceIdentifier)
+        {
+            profiles.erase(deviceIdentifier);
+        }
+
+        std::size_t Size() const
+        {
+            return profiles.size();
+        }
+
+        /// @brief Whether every finger has a range to normalize with
+        static bool IsUsable(const CalibrationData& data)
+        {
+            for (const FingerCalibrationData& finger : data.angles)
+            {
+                if (finger.min >= finger.max) return false;
+            }
+            return true;
+        }
+
+    private:
+        std::map<std::string, CalibrationData> profiles;
+
+        static bool IsValidIdentifier(const std::string& identifier)
+        {
+            return !identifier.empty() && identifier.find_first_of("\t\r\n") == std::string::npos;
+        }
+
+        void ParseLine(const char* line)
+        {
+            const char* separator = line;
+            while (*separator != '\0' && *separator != '\t') separator++;
+            if (*separator != '\t' || separator == line) return;
+
+            CalibrationData data;
+            const char* position = separator + 1;
+            for (FingerCalibrationData& finger : data.angles)
+            {
+                int consumed = 0;
+                if (std::sscanf(position, " %d %d%n", &finger.min, &finger.max, &consumed) != 2) return;
+                position += consumed;
+            }
+            Store(std::string(line, separator), data);
+        }
+    };
+}
@@ -0,0 +1,369 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace feel
+{
+    /// @brief Which way a captured message went
+    enum class CaptureDirection
+    {
+        /// @brief Received from the glove
+        Inbound = 0,
+        /// @brief Sent to the glove
+        Outbound = 1
+    };
+
+    /// @brief One message of a capture
+    ///
+    /// The data points into the capture and is not null terminated.
+    struct CaptureRecord
+    {
+        CaptureDirection direction;
+        /// @brief Microseconds since the capture was started, may be
+        /// slightly negative for messages received before that.
+        std::int64_t offsetMicroseconds;
+        const char* data;
+        std::size_t length;
+    };
+
+    /// @brief The layout of capture files
+    ///
+    /// A 16 byte header, the magic "FEELCAP" and a version byte followed by the
+    /// wall clock time the capture was started (little endian microseconds since
+    /// the Unix epoch). Every record is then
+    ///   varint  (zigzag(offset delta in microseconds) << 1) | direction
+    ///   varint  length
+    ///   bytes   the message without the '#' terminator
+    /// Varints are LEB128, the delta is relative to the previous record.
+    /// A finger update takes 9 bytes.
+    namespace capture
+    {
+        static constexpr char MAGIC[7] = { 'F', 'E', 'E', 'L', 'C', 'A', 'P' };
+        static constexpr std::uint8_t VERSION = 1;
+        static constexpr std::size_t HEADER_SIZE = 16;
+        static constexpr std::size_t MAX_VARINT_SIZE = 10;
+
+        inline std::size_t WriteVarint(std::uint64_t value, char* out)
+        {
+            std::size_t size = 0;
+            while (value >= 0x80)
+            {
+                out[size++] = static_cast<char>((value & 0x7f) | 0x80);
+                value >>= 7;
+            }
+            out[size++] = static_cast<char>(value);
+            return size;
+        }
+
+        /// @return false if the varint does not end before end
+        inline bool ReadVarint(const char*& position, const char* end, std::uint64_t& value)
+        {
+            value = 0;
+            for (unsigned shift = 0; shift < 64 && position < end; shift += 7)
+            {
+                std::uint8_t byte = static_cast<std::uint8_t>(*position++);
+                value |= std::uint64_t(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0) return true;
+            }
+            return false;
+        }
+
+        inline std::uint64_t ZigZag(std::int64_t value)
+        {
+            return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+        }
+
+        inline std::int64_t UnZigZag(std::uint64_t value)
+        {
+            return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+        }
+    }
+
+    /// @brief Writes messages into a capture file
+    ///
+    /// Records are encoded into a preallocated buffer that is written out
+    /// when it is full, so writing a record never allocates. Not thread safe.
+    class CaptureWriter
+    {
+    public:
+        static constexpr std::size_t BUFFER_SIZE = 64 * 1024;
+
+        CaptureWriter() :
+            file(nullptr),
+            previousOffset(0)
+        {}
+
+        CaptureWriter(const CaptureWriter&) = delete;
+        CaptureWriter& operator=(const CaptureWriter&) = delete;
+
+        ~CaptureWriter()
+        {
+            Close();
+        }
+
+        /// @brief Create the file and start the capture clock
+        /// @return false if the file could not be created
+        bool Open(const char* fileName)
+        {
+            Close();
+            file = std::fopen(fileName, "wb");
+            if (file == nullptr) return false;
+            buffer.reserve(BUFFER_SIZE);
+            buffer.clear();
+            start = std::chrono::steady_clock::now();
+            previousOffset = 0;
+
+            char header[capture::HEADER_SIZE];
+            std::memcpy(header, capture::MAGIC, sizeof(capture::MAGIC));
+            header[7] = static_cast<char>(capture::VERSION);
+            auto wallClock = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+            for (int i = 0; i < 8; i++)
+            {
+                header[8 + i] = static_cast<char>(static_cast<std::uint64_t>(wallClock) >> (8 * i));
+            }
+            buffer.insert(buffer.end(), header, header + sizeof(header));
+            return true;
+        }
+
+        bool IsOpen() const
+        {
+            return file != nullptr;
+        }
+
+        /// @brief Write out the buffered records and close the file
+        void Close()
+        {
+            if (file == nullptr) return;
+            Flush();
+            std::fclose(file);
+            file = nullptr;
+        }
+
+        void Flush()
+        {
+            if (file == nullptr || buffer.empty()) return;
+            std::fwrite(buffer.data(), 1, buffer.size(), file);
+            buffer.clear();
+            std::fflush(file);
+        }
+
+        /// @param timestamp When the message was received or sent
+        void Write(CaptureDirection direction, std::chrono::steady_clock::time_point timestamp, const char* data, std::size_t length)
+        {
+            if (file == nullptr) return;
+            std::int64_t offset = std::chrono::duration_cast<std::chrono::microseconds>(timestamp - start).count();
+            char prefix[2 * capture::MAX_VARINT_SIZE];
+            std::size_t prefixSize = capture::WriteVarint((capture::ZigZag(offset - previousOffset) << 1) | static_cast<std::uint64_t>(direction), prefix);
+            prefixSize += capture::WriteVarint(length, prefix + prefixSize);
+            previousOffset = offset;
+
+            if (buffer.size() + prefixSize + length > BUFFER_SIZE)
+            {
+                Flush();
+            }
+            buffer.insert(buffer.end(), prefix, prefix + prefixSize);
+            if (prefixSize + length > BUFFER_SIZE)
+            {
+                // Too long to ever be buffered
+                Flush();
+                std::fwrite(data, 1, length, file);
+                return;
+            }
+            buffer.insert(buffer.end(), data, data + length);
+        }
+
+    private:
+        std::FILE* file;
+        std::vector<char> buffer;
+        std::chrono::steady_clock::time_point start;
+        std::int64_t previousOffset;
+    };
+
+    /// @brief Reads a capture file through a read-only memory mapping
+    ///
+    /// The records point directly into the mapping, reading them neither
+    /// copies nor allocates. They stay valid until Close() is called.
+    class CaptureReader
+    {
+    public:
+        CaptureReader() :
+            begin(nullptr),
+            end(nullptr),
+            position(nullptr),
+            offset(0),
+            wallClockMicroseconds(0)
+#ifdef _WIN32
+            , fileHandle(INVALID_HANDLE_VALUE),
+            mappingHandle(NULL)
+#endif
+        {}
+
+        CaptureReader(const CaptureReader&) = delete;
+        CaptureReader& operator=(const CaptureReader&) = delete;
+
+        ~CaptureReader()
+        {
+            Close();
+        }
+
+        /// @brief Map the file and check its header
+        /// @return false if the file cannot be mapped or is no capture
+        bool Open(const char* fileName)
+        {
+            Close();
+            if (!Map(fileName)) return false;
+            if (static_cast<std::size_t>(end - begin) < capture::HEADER_SIZE
+                || std::memcmp(begin, capture::MAGIC, sizeof(capture::MAGIC)) != 0
+                || static_cast<std::uint8_t>(begin[7]) != capture::VERSION)
+            {
+                Close();
+                return false;
+            }
+            std::uint64_t wallClock = 0;
+            for (int i = 0; i < 8; i++)
+            {
+                wallClock |= std::uint64_t(static_cast<std::uint8_t>(begin[8 + i])) << (8 * i);
+            }
+            wallClockMicroseconds = static_cast<std::int64_t>(wallClock);
+            Rewind();
+            return true;
+        }
+
+        void Close()
+        {
+            Unmap();
+            begin = end = position = nullptr;
+        }
+
+        bool IsOpen() const
+        {
+            return begin != nullptr;
+        }
+
+        /// @brief Start reading at the first record again
+        void Rewind()
+        {
+            position = begin == nullptr ? nullptr : begin + capture::HEADER_SIZE;
+            offset = 0;
+        }
+
+        /// @brief Read the next record
+        /// @return false at the end of the capture, a record cut short
+        /// (e.g. by a crash while recording) ends it as well
+        bool Next(CaptureRecord& record)
+        {
+            if (position == end) return false;
+            const char* next = position;
+            std::uint64_t header;
+            std::uint64_t length;
+            if (!capture::ReadVarint(next, end, header) || !capture::ReadVarint(next, end, length)
+                || length > static_cast<std::uint64_t>(end - next))
+            {
+                position = end;
+                return false;
+            }
+            offset += capture::UnZigZag(header >> 1);
+            record.direction = static_cast<CaptureDirection>(header & 1);
+            record.offsetMicroseconds = offset;
+            record.data = next;
+            record.length = static_cast<std::size_t>(length);
+            position = next + length;
+            return true;
+        }
+
+        /// @brief The wall clock time the capture was started, microseconds since the Unix epoch
+        std::int64_t WallClockMicroseconds() const
+        {
+            return wallClockMicroseconds;
+        }
+
+        /// @brief How far the capture has been read, 0 - 1
+        double Progress() const
+        {
+            if (end - begin <= static_cast<std::ptrdiff_t>(capture::HEADER_SIZE)) return 1;
+            return double(position - begin - capture::HEADER_SIZE) / double(end - begin - capture::HEADER_SIZE);
+        }
+
+    private:
+        const char* begin;
+        const char* end;
+        const char* position;
+        std::int64_t offset;
+        std::int64_t wallClockMicroseconds;
+#ifdef _WIN32
+        HANDLE fileHandle;
+        HANDLE mappingHandle;
+
+        bool Map(const char* fileName)
+        {
+            fileHandle = CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if (fileHandle == INVALID_HANDLE_VALUE) return false;
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0)
+            {
+                Unmap();
+                return false;
+            }
+            mappingHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+            const void* view = mappingHandle == NULL ? nullptr : MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+            if (view == nullptr)
+            {
+                Unmap();
+                return false;
+            }
+            begin = static_cast<const char*>(view);
+            end = begin + size.QuadPart;
+            return true;
+        }
+
+        void Unmap()
+        {
+            if (begin != nullptr) UnmapViewOfFile(begin);
+            if (mappingHandle != NULL) CloseHandle(mappingHandle);
+            if (fileHandle != INVALID_HANDLE_VALUE) CloseHandle(fileHandle);
+            mappingHandle = NULL;
+            fileHandle = INVALID_HANDLE_VALUE;
+        }
+#else
+        bool Map(const char* fileName)
+        {
+            int descriptor = open(fileName, O_RDONLY);
+            if (descriptor < 0) return false;
+            struct stat info;
+            if (fstat(descriptor, &info) != 0 || info.st_size == 0)
+            {
+                close(descriptor);
+                return false;
+            }
+            void* view = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+            // The mapping keeps the file alive
+            close(descriptor);
+            if (view == MAP_FAILED) return false;
+            madvise(view, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+            begin = static_cast<const char*>(view);
+            end = begin + info.st_size;
+            return true;
+        }
+
+        void Unmap()
+        {
+            if (begin != nullptr) munmap(const_cast<char*>(begin), static_cast<std::size_t>(end - begin));
+        }
+#endif
+    };
+}
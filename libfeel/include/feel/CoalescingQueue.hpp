@@ -0,0 +1,178 @@
+#pragma once
+#include "feel/CommandBuffer.hpp"
+#include "feel/Finger.hpp"
+#include "feel/MessageFields.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace feel
+{
+    /// @brief Bounded outgoing queue where the latest finger command wins.
+    ///
+    /// A "WF" or "RE" for a finger that is still waiting to be sent is
+    /// replaced in place by a newer one, so the device never works through
+    /// outdated targets. Every other message ("IN", "BS", "ES", ...) keeps its
+    /// position and also acts as a barrier: finger commands queued after it
+    /// are never merged into ones queued before it.
+    ///
+    /// The critical sections only copy a CommandBuffer, since replacing a
+    /// pending entry needs the producer to touch slots the consumer reads.
+    ///
+    /// Every command can carry the time it was queued at, a replaced
+    /// command takes the time of the newer one.
+    template<std::size_t Capacity>
+    class CoalescingQueue
+    {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        CoalescingQueue() :
+            head(0),
+            tail(0),
+            overflows(0),
+            coalesced(0)
+        {
+            pendingFinger.fill(std::size_t(NONE));
+        }
+
+        CoalescingQueue(const CoalescingQueue&) = delete;
+        CoalescingQueue& operator=(const CoalescingQueue&) = delete;
+
+        /// @return false if the queue was full and the command was dropped
+        bool TryPush(const CommandBuffer& command, std::chrono::steady_clock::time_point enqueued = {})
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return Push(command, enqueued);
+        }
+
+        /// @brief Push several commands under a single lock
+        /// @return The number of commands that were queued
+        std::size_t TryPush(const CommandBuffer* commands, std::size_t count, std::chrono::steady_clock::time_point enqueued = {})
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::size_t pushed = 0;
+            for (std::size_t i = 0; i < count; i++)
+            {
+                if (Push(commands[i], enqueued)) pushed++;
+            }
+            return pushed;
+        }
+
+        /// @return false if there was nothing to send
+        bool TryPop(CommandBuffer& command)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (head == tail) return false;
+            Pop(command, nullptr);
+            return true;
+        }
+
+        /// @brief Take everything that is pending (up to max commands) under a single lock
+        /// @param enqueued If not null, receives the time each command was queued at
+        /// @return The number of commands written to commands
+        std::size_t TryPopAll(CommandBuffer* commands, std::size_t max, std::chrono::steady_clock::time_point* enqueued = nullptr)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::size_t count = 0;
+            while (count < max && head != tail)
+            {
+                Pop(commands[count], enqueued ? enqueued + count : nullptr);
+                count++;
+            }
+            return count;
+        }
+
+        bool Empty()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return head == tail;
+        }
+
+        /// @brief How many commands were dropped because the queue was full
+        std::uint64_t OverflowCount() const
+        {
+            return overflows.load(std::memory_order_relaxed);
+        }
+
+        /// @brief How many pending finger commands were replaced by newer ones
+        std::uint64_t CoalescedCount() const
+        {
+            return coalesced.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Slot
+        {
+            CommandBuffer command;
+            std::chrono::steady_clock::time_point enqueued;
+            int finger = -1;
+        };
+
+        static constexpr std::size_t NONE = ~std::size_t(0);
+
+        std::mutex mutex;
+        std::size_t head;
+        std::size_t tail;
+        std::array<Slot, Capacity> slots;
+        std::array<std::size_t, FINGER_TYPE_COUNT> pendingFinger;
+        std::atomic<std::uint64_t> overflows;
+        std::atomic<std::uint64_t> coalesced;
+
+        bool Push(const CommandBuffer& command, std::chrono::steady_clock::time_point enqueued)
+        {
+            int finger = FingerOf(command);
+            if (finger >= 0 && pendingFinger[finger] != NONE)
+            {
+                Slot& pending = slots[pendingFinger[finger] & (Capacity - 1)];
+                pending.command = command;
+                pending.enqueued = enqueued;
+                coalesced.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+            if (tail - head == Capacity)
+            {
+                overflows.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            Slot& slot = slots[tail & (Capacity - 1)];
+            slot.command = command;
+            slot.enqueued = enqueued;
+            slot.finger = finger;
+            if (finger >= 0)
+            {
+                pendingFinger[finger] = tail;
+            }
+            else
+            {
+                pendingFinger.fill(std::size_t(NONE));
+            }
+            tail++;
+            return true;
+        }
+
+        void Pop(CommandBuffer& command, std::chrono::steady_clock::time_point* enqueued)
+        {
+            Slot& slot = slots[head & (Capacity - 1)];
+            command = slot.command;
+            if (enqueued) *enqueued = slot.enqueued;
+            if (slot.finger >= 0 && pendingFinger[slot.finger] == head)
+            {
+                pendingFinger[slot.finger] = NONE;
+            }
+            head++;
+        }
+
+        /// @return the finger a "WF"/"RE" targets, -1 for every other message
+        static int FingerOf(const CommandBuffer& command)
+        {
+            if (!command.HasIdentifier("WF") && !command.HasIdentifier("RE")) return -1;
+            MessageFields fields(command.Data(), command.MessageSize());
+            int finger = fields.Finger();
+            return fields.Error() == FrameError::None ? finger : -1;
+        }
+    };
+}
@@ -0,0 +1,175 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace feel
+{
+    /// @brief A fixed-size outgoing message frame.
+    ///
+    /// Holds the identifier, the payload and the terminating '#'
+    /// in one stack allocated buffer, so a device can send
+    /// Data() / Size() as-is without building any strings.
+    class CommandBuffer
+    {
+    public:
+        static constexpr std::size_t IDENTIFIER_WIDTH = 2;
+        static constexpr std::size_t FINGER_WIDTH = 2;
+        static constexpr std::size_t FORCE_WIDTH = 2;
+        static constexpr std::size_t ANGLE_WIDTH = 3;
+        static constexpr std::size_t SEQUENCE_WIDTH = 4;
+        static constexpr std::size_t CAPACITY = 32;
+        static constexpr char TERMINATOR = '#';
+
+        CommandBuffer() :
+            length(0)
+        {
+            data[0] = TERMINATOR;
+        }
+
+        /// @brief Build a frame from an identifier and a payload
+        /// @return false if the message does not fit into the buffer
+        bool Assign(const char* identifier, std::size_t identifierLength, const char* payload, std::size_t payloadLength)
+        {
+            if (identifierLength + payloadLength + 1 > CAPACITY) return false;
+            std::memcpy(data.data(), identifier, identifierLength);
+            std::memcpy(data.data() + identifierLength, payload, payloadLength);
+            length = static_cast<std::uint8_t>(identifierLength + payloadLength);
+            data[length] = TERMINATOR;
+            return true;
+        }
+
+        /// @brief "WF": move a finger to an angle with the given (already inverted) force
+        static CommandBuffer WriteFinger(int finger, int force, int angle)
+        {
+            CommandBuffer command("WF");
+            command.AppendHex(finger, FINGER_WIDTH);
+            command.AppendDecimal(force, FORCE_WIDTH);
+            command.AppendDecimal(angle, ANGLE_WIDTH);
+            command.Terminate();
+            return command;
+        }
+
+        /// @brief "RE": release the force from a finger
+        static CommandBuffer ReleaseFinger(int finger)
+        {
+            CommandBuffer command("RE");
+            command.AppendHex(finger, FINGER_WIDTH);
+            command.Terminate();
+            return command;
+        }
+
+        /// @brief "IN": start the normalization
+        static CommandBuffer StartNormalization()
+        {
+            return Identifier("IN");
+        }
+
+        /// @brief "BS": begin the session
+        static CommandBuffer BeginSession()
+        {
+            return Identifier("BS");
+        }
+
+        /// @brief "ES": end the session
+        static CommandBuffer EndSession()
+        {
+            return Identifier("ES");
+        }
+
+        /// @brief "PI": ask the device to echo the sequence number back in a "PO"
+        static CommandBuffer LatencyProbe(std::uint16_t sequence)
+        {
+            CommandBuffer command("PI");
+            command.AppendHex(sequence, SEQUENCE_WIDTH);
+            command.Terminate();
+            return command;
+        }
+
+        /// @brief The whole frame, including the terminator
+        const char* Data() const
+        {
+            return data.data();
+        }
+
+        /// @brief Size of the whole frame, including the terminator
+        std::size_t Size() const
+        {
+            return length + 1;
+        }
+
+        /// @brief Size of identifier and payload, without the terminator
+        std::size_t MessageSize() const
+        {
+            return length;
+        }
+
+        const char* Payload() const
+        {
+            return data.data() + IDENTIFIER_WIDTH;
+        }
+
+        std::size_t PayloadSize() const
+        {
+            return length > IDENTIFIER_WIDTH ? length - IDENTIFIER_WIDTH : 0;
+        }
+
+        bool HasIdentifier(const char* identifier) const
+        {
+            return length >= IDENTIFIER_WIDTH && data[0] == identifier[0] && data[1] == identifier[1];
+        }
+
+    private:
+        std::array<char, CAPACITY> data;
+        std::uint8_t length;
+
+        explicit CommandBuffer(const char* identifier) :
+            length(IDENTIFIER_WIDTH)
+        {
+            data[0] = identifier[0];
+            data[1] = identifier[1];
+        }
+
+        static CommandBuffer Identifier(const char* identifier)
+        {
+            CommandBuffer command(identifier);
+            command.Terminate();
+            return command;
+        }
+
+        void Terminate()
+        {
+            data[length] = TERMINATOR;
+        }
+
+        // Fields are fixed width, values that do not fit are clamped
+        // so a frame never grows beyond its expected size.
+        void AppendHex(int value, std::size_t width)
+        {
+            static const char digits[] = "0123456789abcdef";
+            unsigned int v = value < 0 ? 0u : static_cast<unsigned int>(value);
+            unsigned int max = (1u << (4 * width)) - 1;
+            if (v > max) v = max;
+            for (std::size_t i = width; i > 0; i--)
+            {
+                data[length + i - 1] = digits[v & 0xf];
+                v >>= 4;
+            }
+            length += static_cast<std::uint8_t>(width);
+        }
+
+        void AppendDecimal(int value, std::size_t width)
+        {
+            int max = 1;
+            for (std::size_t i = 0; i < width; i++) max *= 10;
+            int v = value < 0 ? 0 : (value >= max ? max - 1 : value);
+            for (std::size_t i = width; i > 0; i--)
+            {
+                data[length + i - 1] = static_cast<char>('0' + v % 10);
+                v /= 10;
+            }
+            length += static_cast<std::uint8_t>(width);
+        }
+    };
+}
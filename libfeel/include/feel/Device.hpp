@@ -3,17 +3,120 @@
 #include <functional>
 #include <vector>
 #include "feel/DeviceStatus.hpp"
+#include "feel/CommandBuffer.hpp"
+#include "feel/DeviceStatistics.hpp"
+#include "feel/ReceivedMessage.hpp"
+#include "feel/MessageBatch.hpp"
+#include "feel/LatencyHistogram.hpp"
+#include <chrono>
 
 namespace feel
 {
 	class Device
 	{
 	public:
+        virtual ~Device() = default;
+
         virtual DeviceStatus GetStatus() = 0;
 		virtual void Connect(const char* deviceName) = 0;
         virtual void Disconnect() = 0;
         virtual void GetAvailableDevices(std::vector<std::string>& devices) = 0;
 		virtual void TransmitMessage(std::string identifier, std::string payload = "") = 0;
+
+        /// @brief Transmit a preencoded frame.
+        ///
+        /// Devices should override this to send the buffer directly,
+        /// the default falls back to the string based overload.
+        virtual void TransmitMessage(const CommandBuffer& command)
+        {
+            TransmitMessage(
+                std::string(command.Data(), CommandBuffer::IDENTIFIER_WIDTH),
+                std::string(command.Payload(), command.PayloadSize()));
+        }
+
+        /// @brief Transmit several preencoded frames at once.
+        ///
+        /// Devices should override this to queue all frames
+        /// and wake their writer only once.
+        virtual void TransmitMessages(const CommandBuffer* commands, std::size_t count)
+        {
+            for (std::size_t i = 0; i < count; i++)
+            {
+                TransmitMessage(commands[i]);
+            }
+        }
+
 		virtual void IterateAllMessages(std::function<void(const std::string&)> callback) = 0;
+
+        /// @brief Iterate all messages together with the time they were received.
+        ///
+        /// Devices should override this to report the actual arrival time,
+        /// the default stamps every message with the current time.
+        virtual void IterateReceivedMessages(std::function<void(const ReceivedMessage&)> callback)
+        {
+            auto now = std::chrono::steady_clock::now();
+            IterateAllMessages([&](const std::string& message)
+            {
+                callback(ReceivedMessage{ message.data(), message.size(), now });
+            });
+        }
+
+        /// @brief Take all received messages at once
+        ///
+        /// Replaces the contents of batch. The messages stay valid until the
+        /// batch is cleared or the device is drained again. Reuse the same
+        /// batch every time, it keeps its memory.
+        /// Devices should override this to fill the batch without a call per
+        /// message, the default copies what IterateReceivedMessages() passes.
+        virtual void DrainMessages(MessageBatch& batch)
+        {
+            batch.Clear();
+            IterateReceivedMessages([&batch](const ReceivedMessage& message)
+            {
+                batch.Append(message.data, message.length, message.timestamp);
+            });
+        }
+
+        /// @brief Set a function to call whenever new messages were received
+        /// or the connection was lost.
+        ///
+        /// The listener is called on the thread that receives the messages,
+        /// so it should return quickly. Pass an empty function to remove it.
+        /// @return false if the device does not support listeners
+        virtual bool SetReceiveListener(std::function<void()> /*listener*/)
+        {
+            return false;
+        }
+
+        /// @brief Timestamp outgoing messages to measure how long they wait to be sent.
+        ///
+        /// Enabling it clears the measurements taken so far.
+        /// @return false if the device does not support it
+        virtual bool SetInstrumentation(bool /*enabled*/)
+        {
+            return false;
+        }
+
+        /// @brief Get the time from TransmitMessage() until the message was written to the port
+        virtual LatencyHistogramData GetSendLatency()
+        {
+            return LatencyHistogramData();
+        }
+
+        /// @brief Get a name that identifies the connected glove
+        ///
+        /// Unlike the name passed to Connect() it should stay the same when the
+        /// glove is plugged into another port, where the device can tell.
+        /// @return An empty string if the device cannot identify the glove
+        virtual std::string GetDeviceIdentifier()
+        {
+            return "";
+        }
+
+        /// @brief Get the counters collected by the device
+        virtual DeviceStatistics GetStatistics()
+        {
+            return DeviceStatistics();
+        }
 	};
 }
\ No newline at end of file
@@ -0,0 +1,16 @@
+#pragma once
+#include <cstdint>
+
+namespace feel
+{
+    /// @brief Counters collected by a device
+    struct DeviceStatistics
+    {
+        /// @brief Incoming messages dropped because they were not parsed in time
+        std::uint64_t inputOverflows = 0;
+        /// @brief Outgoing messages dropped because the device could not send them in time
+        std::uint64_t outputOverflows = 0;
+        /// @brief Outgoing finger commands replaced by a newer one before they were sent
+        std::uint64_t coalescedOutputs = 0;
+    };
+}
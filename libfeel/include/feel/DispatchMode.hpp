@@ -0,0 +1,27 @@
+#pragma once
+#include "feel/ThreadSettings.hpp"
+#include <chrono>
+
+namespace feel
+{
+    /// @brief Where incoming messages are processed
+    enum class DispatchMode
+    {
+        /// @brief Only when the application calls Feel::ParseMessages()
+        Polling,
+        /// @brief On the device's receiving thread, as soon as messages arrive
+        IoThread,
+        /// @brief On a thread owned by Feel, woken by the device's receiving thread
+        /// or, for devices that cannot notify, every DispatchSettings::pollInterval
+        DispatchThread
+    };
+
+    /// @brief Options of DispatchMode::DispatchThread
+    struct DispatchSettings
+    {
+        /// @brief CPU and priority of the thread
+        ThreadSettings thread;
+        /// @brief How often a device that cannot notify is checked for messages
+        std::chrono::microseconds pollInterval{ 500 };
+    };
+}
@@ -1,19 +1,33 @@
 #pragma once
 #include "feel/Device.hpp"
 #include "feel/Finger.hpp"
-#include "feel/IncomingMessage.hpp"
+#include "feel/GloveState.hpp"
+#include "feel/SharedFrame.hpp"
 #include "feel/FeelStatus.hpp"
 #include "feel/CalibrationData.hpp"
-#include <iomanip>
-#include <map>
+#include "feel/CommandBuffer.hpp"
+#include "feel/FingerTarget.hpp"
+#include "feel/FingerCommandEncoder.hpp"
+#include "feel/FingerHistory.hpp"
+#include "feel/FingerFilter.hpp"
+#include "feel/FingerPredictor.hpp"
+#include "feel/DispatchMode.hpp"
+#include "feel/Log.hpp"
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <cassert>
 #include <functional>
 #include <algorithm>
 #include <cmath>
 #include <string>
-#include <iostream>
-#include <sstream>
 #include <limits>
 
 namespace feel
@@ -25,14 +39,27 @@ namespace feel
         /// @brief Creates a new instance
         /// @param device The underlying device to use.
         /// @note The given device will be deleted in the destructor.       
-        Feel(Device* device)
+        Feel(Device* device) :
+            device(device),
+            glove(device, filterBatch, 0)
         {
-            calibrationData.angles.fill(FingerCalibrationData{ 0, 180 });
-            this->device = device;
+            for (std::atomic<float>& angle : fingerAngles)
+            {
+                angle.store(0, std::memory_order_relaxed);
+            }
+            filterBatch.SetProcessedListener([this](const float* present)
+            {
+                for (int i = 0; i < FINGER_TYPE_COUNT; i++)
+                {
+                    if (present[i] != 0) fingerAngles[i].store(filterBatch.Filters().Output(i), std::memory_order_relaxed);
+                }
+                glove.FinishFilterBatch(present);
+            });
         }
 
         ~Feel()
         {
+            StopDispatch();
             delete device;
         }
 
@@ -40,15 +67,75 @@ namespace feel
         /// @param deviceName The name of the device to connect to. (A name returned by GetAvailableDevices() )
         void Connect(const char* deviceName)
         {
+            {
+                std::lock_guard<std::recursive_mutex> lock(parseMutex);
+                connectedName = deviceName;
+            }
             device->Connect(deviceName);
-            UpdateStatus();
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            glove.UpdateStatus();
         }
 
         /// @brief Diconnect from the Device
         void Disconnect()
         {
+            // Not under the lock, the device may wait for its receiving thread
             device->Disconnect();
-            UpdateStatus();
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            glove.UpdateStatus();
+        }
+
+        /// @brief Set where incoming messages are processed.
+        ///
+        /// In DispatchMode::Polling (the default) nothing happens until ParseMessages() is called.
+        /// In the other modes messages are processed as soon as the device receives them
+        /// and the handlers (SetFingerUpdateHandler(), SetStatusChangeHandler(), ...)
+        /// are called on that thread. The getters may still be called from any thread,
+        /// except GetFingerHistory() which should only be used inside a handler.
+        ///
+        /// DispatchMode::DispatchThread keeps the filtered angles current without any
+        /// calls from the application, the device's queue stays close to empty.
+        /// GetFingerAngle() and GetFrameSnapshot() do not wait for its parsing.
+        /// @param mode The mode to use
+        /// @param settings CPU, priority and poll interval of DispatchMode::DispatchThread
+        /// @return false if the device cannot notify about received messages in
+        /// DispatchMode::IoThread, Feel stays in DispatchMode::Polling in that case.
+        bool SetDispatchMode(DispatchMode mode, const DispatchSettings& settings = DispatchSettings())
+        {
+            StopDispatch();
+            if (mode == DispatchMode::Polling) return true;
+
+            if (mode == DispatchMode::IoThread)
+            {
+                if (!device->SetReceiveListener([this]() { ParseMessages(); }))
+                {
+                    StopDispatch();
+                    return false;
+                }
+            }
+            else
+            {
+                dispatchSettings = settings;
+                dispatchRunning = true;
+                // Devices that cannot notify are polled by the thread
+                dispatchPolled = !device->SetReceiveListener([this]()
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(dispatchMutex);
+                        dispatchPending = true;
+                    }
+                    dispatchSignal.notify_one();
+                });
+                dispatchWorker = std::thread(&Feel::DispatchThread, this);
+            }
+            dispatchMode = mode;
+            return true;
+        }
+
+        /// @brief Get the mode set by SetDispatchMode()
+        DispatchMode GetDispatchMode() const
+        {
+            return dispatchMode;
         }
 
         //@{
@@ -61,7 +148,7 @@ namespace feel
         {
             std::vector<std::string> devices;
             device->GetAvailableDevices(devices);
-            return std::move(devices);
+            return devices;
         }
 
         /// @post all names have been added to the vector
@@ -76,9 +163,8 @@ namespace feel
         /// Afterwards BeginSession() can be called
         void StartNormalization()
         {
-            calibrationData.angles.fill(FingerCalibrationData{ std::numeric_limits<int>::max() , std::numeric_limits<int>::min() });
-            device->TransmitMessage("IN");
-            status = FeelStatus::Normalization;
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            glove.StartNormalization();
         }
 
         /// @brief Set the normalization data.
@@ -88,7 +174,42 @@ namespace feel
         /// @param data The normalization data.
         void SetCalibrationData(CalibrationData& data)
         {
-            calibrationData = data;
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            glove.SetCalibrationData(data);
+            PublishFrame();
+        }
+
+        /// @brief Get the normalization data, e.g. to save it after StartNormalization()
+        /// @see CalibrationStore
+        CalibrationData GetCalibrationData() const
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            return glove.GetCalibrationData();
+        }
+
+        /// @brief Get a name identifying the connected glove, to store its calibration data with
+        ///
+        /// Falls back to the name passed to Connect() if the device cannot identify the glove.
+        std::string GetDeviceIdentifier()
+        {
+            std::string identifier = device->GetDeviceIdentifier();
+            if (!identifier.empty()) return identifier;
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            return connectedName;
+        }
+
+        /// @brief Check calibration data set with SetCalibrationData() against the glove
+        ///
+        /// Compares the raw angles received since BeginSession() with the calibrated ranges.
+        /// Data of another glove, or of one that needs to be normalized again, is
+        /// usually detected within a few updates.
+        /// @param minimumSamples How many updates every finger needs before the data counts as valid
+        /// @param tolerance How far a sample may lie outside of the range, as a fraction of the range
+        /// @return CalibrationCheck::Pending until every finger sent minimumSamples updates
+        CalibrationCheck CheckCalibration(std::uint32_t minimumSamples = 5, float tolerance = 0.1f) const
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            return glove.CheckCalibration(minimumSamples, tolerance);
         }
 
         /// @brief Starts the session.
@@ -98,20 +219,20 @@ namespace feel
         /// otherwise angles returned from GetFingerAngle() might not be correct
 		void BeginSession()
         {
-            device->TransmitMessage("BS");
-            for (int i = 0; i < feel::FINGER_TYPE_COUNT; i++)
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            for (std::atomic<float>& angle : fingerAngles)
             {
-                fingerAngles[i] = calibrationData.angles[i].min;
+                angle.store(0, std::memory_order_relaxed);
             }
-            status = FeelStatus::Active;
+            glove.BeginSession();
+            PublishFrame();
         }
 
         /// @brief Ends the session started by BeginSession()
 		void EndSession()
 		{
-			device->TransmitMessage("ES");
-            status = FeelStatus::DeviceConnected;
-            UpdateStatus();
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            glove.EndSession();
 		}
 
         /// @brief Move a finger to a specific angle
@@ -121,29 +242,11 @@ namespace feel
         /// \note The force may not be applied immediately.
 		void SetFingerAngle(Finger finger, float angle, int force)
 		{
-			int fingerNumber = static_cast<int>(finger);
-            FingerOperationStatus& status = fingerStatus[fingerNumber];
-            force = 99 - force;
-            int degree = (int)std::round(angle);
-            if (status.on &&
-                status.targetAngle == degree &&
-                status.targetForce == force)
+            CommandBuffer command;
+            if (encoder.EncodeFingerAngle(finger, angle, force, command))
             {
-                return;
+                device->TransmitMessage(command);
             }
-            auto data = calibrationData.angles[fingerNumber];
-			std::stringstream stream;
-			stream
-				<< std::setfill('0') << std::setw(2)
-				<< std::hex << fingerNumber
-				<< std::dec << std::setw(2)
-                << force
-                << std::dec << std::setw(3)
-                << degree;
-			device->TransmitMessage("WF", stream.str());
-            status.targetAngle = degree;
-            status.targetForce = force;
-            status.on = true;
 		}
 
         /// @brief Release the force from a finger.
@@ -152,14 +255,23 @@ namespace feel
         /// @param finger The finger to release
         void ReleaseFinger(Finger finger)
         {
-            FingerOperationStatus& status = fingerStatus[static_cast<int>(finger)];
-            if (!status.on) return;
-            std::stringstream stream;
-            stream
-                << std::setfill('0') << std::setw(2)
-                << std::hex << static_cast<int>(finger);
-            device->TransmitMessage("RE", stream.str());
-            status.on = false;
+            CommandBuffer command;
+            if (encoder.EncodeReleaseFinger(finger, command))
+            {
+                device->TransmitMessage(command);
+            }
+        }
+
+        /// @brief Move or release several fingers at once
+        ///
+        /// Behaves like calling SetFingerAngle() or ReleaseFinger() for every target,
+        /// but all resulting commands are handed to the device as one batch.
+        /// This should be preferred when updating a whole hand every frame.
+        /// @param targets The targets, one per finger
+        /// @param count   The number of targets
+        void SetFingerTargets(const FingerTarget* targets, std::size_t count)
+        {
+            encoder.TransmitTargets(*device, targets, count);
         }
 
         /// @brief Get the angle a finger is at.
@@ -168,119 +280,435 @@ namespace feel
         /// @return The angle the finger is at, ranges from 0 - 180.
 		float GetFingerAngle(Finger finger) const
 		{
-            auto angle = fingerAngles[static_cast<int>(finger)];
-            auto data = calibrationData.angles[static_cast<int>(finger)];
-            angle = (angle - data.min) / (data.max - data.min) * 180;
-            return angle;
+            // Does not wait for ParseMessages() on another thread
+            return fingerAngles[static_cast<int>(finger)].load(std::memory_order_relaxed);
+        }
+
+        /// @brief Get the angles of all fingers at once
+        ///
+        /// Like GetFingerAngle() for every finger, indexed by feel::Finger,
+        /// but all angles are of the same frame.
+        /// @param angles Room for count angles
+        /// @param count  At most FINGER_TYPE_COUNT angles are written
+        /// @return The number of angles written
+        std::size_t GetFingerAngles(float* angles, std::size_t count) const
+        {
+            count = std::min(count, static_cast<std::size_t>(FINGER_TYPE_COUNT));
+            FrameState frame;
+            if (!GetFrameSnapshot(frame)) frame.angles.fill(0);
+            std::copy(frame.angles.begin(), frame.angles.begin() + count, angles);
+            return count;
+        }
+
+        /// @brief Set how the samples of a finger are filtered.
+        ///
+        /// The filtered value is returned by GetFingerAngle(),
+        /// the default is a One-Euro filter.
+        /// @param finger   The finger to configure
+        /// @param settings The filter and its parameters
+        void SetFingerFilter(Finger finger, const FilterSettings& settings)
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            filterBatch.Filters().Configure(static_cast<int>(finger), settings);
+        }
+
+        /// @brief Set how the samples of all fingers are filtered.
+        /// @param settings The filter and its parameters
+        void SetFilter(const FilterSettings& settings)
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            for (int i = 0; i < FINGER_TYPE_COUNT; i++)
+            {
+                filterBatch.Filters().Configure(i, settings);
+            }
+        }
+
+        /// @brief Get the latest unfiltered sample of a finger.
+        ///
+        /// @param finger The finger to get the sample from.
+        /// @return The sample, its angle ranges from 0 - 180.
+        /// \note Returns a default constructed sample if nothing has been received this session.
+        FingerSample GetLatestFingerSample(Finger finger) const
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            const FingerHistory& history = glove.GetFingerHistory(static_cast<int>(finger));
+            return history.Empty() ? FingerSample{} : history.Latest();
+        }
+
+        /// @brief Get how fast a finger is moving.
+        ///
+        /// Computed from the timestamps of the latest samples.
+        /// @param finger The finger to get the velocity from.
+        /// @return The velocity in degrees per second.
+        float GetFingerVelocity(Finger finger) const
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            return glove.GetFingerHistory(static_cast<int>(finger)).Velocity();
+        }
+
+        /// @brief Get the velocities of all fingers at once, see GetFingerAngles()
+        std::size_t GetFingerVelocities(float* velocities, std::size_t count) const
+        {
+            count = std::min(count, static_cast<std::size_t>(FINGER_TYPE_COUNT));
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            for (std::size_t i = 0; i < count; i++)
+            {
+                velocities[i] = glove.GetFingerHistory(static_cast<int>(i)).Velocity();
+            }
+            return count;
+        }
+
+        /// @brief Get how fast the velocity of a finger is changing.
+        ///
+        /// @param finger The finger to get the acceleration from.
+        /// @return The acceleration in degrees per second squared.
+        float GetFingerAcceleration(Finger finger) const
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            return glove.GetFingerHistory(static_cast<int>(finger)).Acceleration();
+        }
+
+        /// @brief Get the angle a finger is expected to have at a given time.
+        ///
+        /// Extrapolates the samples with the model set by SetPrediction(), e.g. to
+        /// render the hand at the time the frame is displayed instead of the time
+        /// the glove measured it. This also makes up for the lag of the filter,
+        /// the prediction starts at the latest unfiltered sample.
+        /// Every prediction is checked against the samples that arrive later,
+        /// see GetPredictionError().
+        /// @param finger     The finger to predict.
+        /// @param targetTime When the angle is needed, at most PredictionSettings::maxHorizon
+        ///                   after the latest sample.
+        /// @return The expected angle, ranges from 0 - 180. GetFingerAngle() before the first sample.
+        float GetPredictedFingerAngle(Finger finger, std::chrono::steady_clock::time_point targetTime)
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            int index = static_cast<int>(finger);
+            const FingerHistory& history = glove.GetFingerHistory(index);
+            if (history.Empty()) return GetFingerAngle(finger);
+            return glove.GetPredictor(index).Predict(history, targetTime);
+        }
+
+        /// @brief Set how GetPredictedFingerAngle() extrapolates, for all fingers
+        ///
+        /// Clears the error statistics.
+        void SetPrediction(const PredictionSettings& settings)
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            for (int i = 0; i < FINGER_TYPE_COUNT; i++)
+            {
+                glove.GetPredictor(i).Configure(settings);
+                // The Kalman filter starts over with the latest sample
+                if (!glove.GetFingerHistory(i).Empty()) glove.GetPredictor(i).Update(glove.GetFingerHistory(i));
+            }
+        }
+
+        /// @brief How far the predictions of a finger were off so far
+        PredictionError GetPredictionError(Finger finger) const
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            return glove.GetPredictor(static_cast<int>(finger)).GetError();
+        }
+
+        /// @brief Start new error statistics, e.g. after changing the time the predictions target
+        void ResetPredictionError()
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            for (int i = 0; i < FINGER_TYPE_COUNT; i++)
+            {
+                glove.GetPredictor(i).ResetError();
+            }
+        }
+
+        /// @brief Get the recent samples of a finger received this session.
+        ///
+        /// @param finger The finger to get the samples from.
+        /// @return The history, valid until the next call to ParseMessages() or BeginSession()
+        const FingerHistory& GetFingerHistory(Finger finger) const
+        {
+            return glove.GetFingerHistory(static_cast<int>(finger));
         }
 
         /// @brief Set which function should be called when a Debug message from
         /// the device is processed
+        ///
+        /// By default the messages go to Logger::Default() with LogLevel::Debug.
+        /// Pass an empty function to restore that.
 		void SetDebugLogCallback(std::function<void(std::string) > callback)
 		{
-			debugLogCallback = callback;
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            if (!callback)
+            {
+                glove.SetDebugLogCallback(nullptr);
+                return;
+            }
+            glove.SetDebugLogCallback([callback](const char* text, std::size_t length)
+            {
+                callback(std::string(text, length));
+            });
 		}
 
+        /// @brief Set the function to call for messages with the given identifier
+        ///
+        /// For messages the library does not know, like firmware telemetry.
+        /// The handler gets the whole message including the identifier and is
+        /// called from ParseMessages() like the other handlers.
+        /// Pass an empty function to remove it.
+        /// @param identifier Two characters, 'A' - 'Z' or '0' - '9'
+        /// @return false if the identifier is invalid or belongs to a built-in message
+        bool RegisterMessageHandler(const char* identifier, std::function<void(const ReceivedMessage&)> handler)
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            return glove.RegisterMessageHandler(identifier, handler);
+        }
+
+        /// @brief The number of received messages with an identifier nothing handles
+        std::uint64_t GetUnknownMessageCount() const
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            return glove.GetUnknownMessageCount();
+        }
+
+        /// @brief The number of malformed messages that were dropped, by reason
+        ///
+        /// Line noise on the serial connection shows up here.
+        RejectedFrameCounts GetRejectedFrameCounts() const
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            return glove.GetRejectedFrameCounts();
+        }
+
+        /// @brief Log every normalization sample through the debug log callback
+        ///
+        /// Off by default, a normalization produces about 1,800 samples.
+        /// Use SetNormalizationSampleHandler() to process them instead.
+        void SetNormalizationLogging(bool enabled)
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            glove.SetNormalizationLogging(enabled);
+        }
+
+        /// @brief Set which function should be called for every new finger sample
+        ///
+        /// When it is called, GetFingerAngle() already includes the sample.
+        /// @param handler Gets the finger and its unfiltered sample
+        void SetFingerUpdateHandler(std::function<void(Finger, const FingerSample&)> handler)
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            glove.SetFingerUpdateHandler(handler);
+        }
+
+        /// @brief Set which function should be called for every sample received during the normalization
+        /// @param handler Gets the finger, the real angle and the raw angle of the sample
+        void SetNormalizationSampleHandler(std::function<void(Finger, int, int)> handler)
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            glove.SetNormalizationSampleHandler(handler);
+        }
+
+        /// @brief Set which function should be called when the device finished the normalization
+        void SetEndNormalizationHandler(std::function<void()> handler)
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            glove.SetEndNormalizationHandler(handler);
+        }
+
+        /// @brief Set which function should be called when GetStatus() changes
+        ///
+        /// Changes caused by a call like BeginSession() are reported on the calling thread.
+        void SetStatusChangeHandler(std::function<void(FeelStatus)> handler)
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            glove.SetStatusChangeHandler(handler);
+        }
+
         /// @brief Get the current feel::FeelStatus
         /// @return The current status
         FeelStatus GetStatus() const
         {
-            return status;
+            return glove.GetStatus();
+        }
+
+        /// @brief Get the counters collected by the device
+        ///
+        /// Growing overflow counters mean ParseMessages() is not called
+        /// often enough to keep up with the device.
+        DeviceStatistics GetDeviceStatistics() const
+        {
+            return device->GetStatistics();
+        }
+
+        /// @brief Measure the latencies listed in feel::LatencyStage.
+        ///
+        /// Enabling it clears the measurements taken so far.
+        /// LatencyStage::Send stays empty if the device does not support it.
+        void SetInstrumentation(bool enabled)
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            glove.SetInstrumentation(enabled);
+        }
+
+        /// @brief Send a probe the device echoes back.
+        ///
+        /// The time until the echo is received is recorded in LatencyStage::RoundTrip,
+        /// this works without SetInstrumentation().
+        /// @return The sequence number of the probe
+        std::uint16_t SendLatencyProbe()
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            return glove.SendLatencyProbe();
+        }
+
+        /// @brief Get the latencies measured so far
+        /// @param stage Which latency to get
+        LatencyHistogramData GetLatencyHistogram(LatencyStage stage) const
+        {
+            return glove.GetLatencyHistogram(stage);
+        }
+
+        /// @brief Get the state of all fingers at once without taking a lock
+        ///
+        /// Any number of threads may call it while another one calls ParseMessages(),
+        /// e.g. a render thread while a DispatchMode::DispatchThread parses.
+        /// It never waits for the parsing and never returns a partly updated frame.
+        /// A new frame is taken by every ParseMessages() that received something or
+        /// changed the status, and by SetCalibrationData().
+        /// @return false if there is no frame yet, state is unchanged then
+        bool GetFrameSnapshot(FrameState& state) const
+        {
+            if (frameSnapshot.Version() == 0) return false;
+            return frameSnapshot.Load(state);
+        }
+
+        /// @brief Publish every parsed frame into shared memory
+        ///
+        /// Other processes, like a recorder or a visualizer, can then read the
+        /// finger angles with SharedFrameReader without a connection of their own.
+        /// A frame is published by every ParseMessages() that received something.
+        /// @param name The name of the segment, e.g. "feel"
+        /// @return false if the segment could not be created
+        bool StartPublishing(const char* name)
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            if (!publisher) publisher.reset(new SharedFramePublisher());
+            if (publisher->Open(name)) return true;
+            publisher.reset();
+            return false;
+        }
+
+        /// @brief Stop publishing and remove the segment
+        void StopPublishing()
+        {
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            publisher.reset();
         }
 
         /// @brief Processes all incoming messages since the last call
         ///
         /// After calling it, all values are updated to the latest version.
-        /// This function should typically be called once per frame.
+        /// This function should typically be called once per frame,
+        /// unless a different mode was set with SetDispatchMode().
+        /// \note Must not be called from inside a handler.
 		void ParseMessages()
 		{
-            UpdateStatus();
-			device->IterateAllMessages([&](auto message)
-			{
-				static std::map<std::string, IncomingMessage> incomingMessageMap =
-				{
-					{ "UF", IncomingMessage::FingerUpdate },
-					{ "DL", IncomingMessage::DebugLog },
-                    { "NI", IncomingMessage::NormalizationData },
-                    { "EN", IncomingMessage::EndNormalization }
-				};
-				if (message.length() < 2) return;
-				switch (incomingMessageMap[message.substr(0, 2)])
-				{
-					case IncomingMessage::DebugLog:
-                    {
-                        debugLogCallback(message.substr(2));
-                    } break;
-					case IncomingMessage::FingerUpdate:
-                    {
-                        std::string fingerIdentifier = message.substr(2, 2);
-                        std::string fingerAngle = message.substr(4);
-                        int fingerIndex = std::stoul(fingerIdentifier, nullptr, 16);                  
-                        fingerAngles[fingerIndex] = fingerAngles[fingerIndex] * 0.9f + std::stoi(fingerAngle) * 0.1f;
-                    } break;
-                    case IncomingMessage::NormalizationData:
-                    {
-                        std::string fingerIdentifier = message.substr(2, 2);
-                        std::string realAngle = message.substr(4, 3);
-                        std::string fingerAngle = message.substr(7);
-                        debugLogCallback("Init Finger: " + fingerIdentifier + " Real Angle: " + realAngle + " Angle: " + fingerAngle);
-                        int fingerIndex = std::stoul(fingerIdentifier, nullptr, 16);
-                        int angle = std::stoi(fingerAngle);
-                        auto data = calibrationData.angles[fingerIndex];
-                        data.min = std::min(data.min, angle);
-                        data.max = std::max(data.max, angle);
-                        calibrationData.angles[fingerIndex] = data;
-                    } break;
-                    case IncomingMessage::EndNormalization:
-                    {
-                        if (status == FeelStatus::Normalization)
-                        {
-                            status = FeelStatus::DeviceConnected;
-                        }
-                    } break;
-				}
-			});
+            std::lock_guard<std::recursive_mutex> lock(parseMutex);
+            // One drain per call, the batch keeps its memory between calls
+            glove.ParseMessages(inputBatch);
+            filterBatch.Process();
+            if (!inputBatch.Empty() || publishedFrame.status != static_cast<std::int32_t>(GetStatus()))
+            {
+                PublishFrame();
+            }
 		}
 
 	private:
-        struct FingerOperationStatus
+        Device* device = nullptr;
+        // The latest frame, for GetFrameSnapshot() and the shared memory
+        FrameState publishedFrame = {};
+        SeqLock<FrameState> frameSnapshot;
+        std::unique_ptr<SharedFramePublisher> publisher;
+
+        // Guards everything ParseMessages() touches, recursive so handlers can use the getters
+        mutable std::recursive_mutex parseMutex;
+        DispatchMode dispatchMode = DispatchMode::Polling;
+        std::thread dispatchWorker;
+        std::mutex dispatchMutex;
+        std::condition_variable dispatchSignal;
+        bool dispatchPending = false;
+        bool dispatchRunning = false;
+        bool dispatchPolled = false;
+        DispatchSettings dispatchSettings;
+        MessageBatch inputBatch;
+        FingerFilterBatch filterBatch{ FINGER_TYPE_COUNT };
+        GloveState glove;
+        // The outputs of the filters, for GetFingerAngle() from other threads
+        std::array<std::atomic<float>, FINGER_TYPE_COUNT> fingerAngles;
+        FingerCommandEncoder encoder;
+        std::string connectedName;
+
+        void FillFrameState(FrameState& state) const
         {
-            bool on = false;
-            int targetAngle = 0;
-            int targetForce = 0;
-        };
+            state.frame++;
+            // The clock is slow to read on some systems, the batch already has a recent time
+            state.timestampMicroseconds = FrameState::Microseconds(inputBatch.Empty() ? std::chrono::steady_clock::now() : inputBatch[inputBatch.Size() - 1].timestamp);
+            state.status = static_cast<std::int32_t>(GetStatus());
+            state.fingerCount = FINGER_TYPE_COUNT;
+            for (int i = 0; i < FINGER_TYPE_COUNT; i++)
+            {
+                const FingerHistory& history = glove.GetFingerHistory(i);
+                state.angles[i] = filterBatch.Filters().Output(i);
+                state.sampleTimestamps[i] = history.Empty() ? 0 : FrameState::Microseconds(history.Latest().timestamp);
+            }
+            state.calibration = glove.GetCalibrationData().angles;
+        }
 
-        FeelStatus status;
-        Device* device = nullptr;
-		std::function<void(std::string)> debugLogCallback = [](auto s)
+        void PublishFrame()
         {
-			std::cout << s << std::endl;
-		};
-		std::array<float, FINGER_TYPE_COUNT> fingerAngles = {0};
-        std::array<FingerOperationStatus, FINGER_TYPE_COUNT> fingerStatus;
-        CalibrationData calibrationData;
+            FillFrameState(publishedFrame);
+            frameSnapshot.Store(publishedFrame);
+            if (publisher) publisher->Publish(publishedFrame);
+        }
 
-        void UpdateStatus()
+        void DispatchThread()
         {
-            switch (status)
+            if (!dispatchSettings.thread.ApplyToCurrentThread())
             {
-                case FeelStatus::DeviceDisconnected:
-                case FeelStatus::DeviceConnecting:
-                case FeelStatus::DeviceConnected:
-                    switch (device->GetStatus())
-                    {
-                        case DeviceStatus::Disconnected:
-                            status = FeelStatus::DeviceDisconnected;
-                            break;
-                        case DeviceStatus::Connecting:
-                            status = FeelStatus::DeviceConnecting;
-                            break;
-                        case DeviceStatus::Connected:
-                            status = FeelStatus::DeviceConnected;
-                            break;
-                    }
-                    break;
+                Logger::Default().Write(LogLevel::Warning, "Could not apply the CPU or priority of the dispatch thread");
+            }
+            // How often the device status is checked without being woken
+            const std::chrono::microseconds statusPollInterval(100000);
+            const std::chrono::microseconds wakeInterval = dispatchPolled ? dispatchSettings.pollInterval : statusPollInterval;
+            std::unique_lock<std::mutex> lock(dispatchMutex);
+            while (dispatchRunning)
+            {
+                dispatchSignal.wait_for(lock, wakeInterval, [this]()
+                {
+                    return dispatchPending || !dispatchRunning;
+                });
+                if (!dispatchRunning) break;
+                dispatchPending = false;
+                lock.unlock();
+                ParseMessages();
+                lock.lock();
+            }
+        }
+
+        void StopDispatch()
+        {
+            // Returns only after a running listener has finished
+            device->SetReceiveListener(nullptr);
+            if (dispatchWorker.joinable())
+            {
+                {
+                    std::lock_guard<std::mutex> lock(dispatchMutex);
+                    dispatchRunning = false;
+                }
+                dispatchSignal.notify_one();
+                dispatchWorker.join();
             }
+            dispatchPending = false;
+            dispatchPolled = false;
+            dispatchMode = DispatchMode::Polling;
         }
 	};
 }
\ No newline at end of file
@@ -0,0 +1,83 @@
+#pragma once
+#include "feel/Device.hpp"
+#include "feel/Finger.hpp"
+#include "feel/FingerTarget.hpp"
+#include "feel/CommandBuffer.hpp"
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+namespace feel
+{
+    /// @brief Turns finger targets of one hand into commands
+    ///
+    /// Remembers the last target of every finger, so targets
+    /// that did not change are not sent again.
+    class FingerCommandEncoder
+    {
+    public:
+        /// @return false if the finger already has this target, command is untouched then
+        bool EncodeFingerAngle(Finger finger, float angle, int force, CommandBuffer& command)
+        {
+			int fingerNumber = static_cast<int>(finger);
+            FingerOperationStatus& status = fingerStatus[fingerNumber];
+            force = 99 - force;
+            int degree = (int)std::round(angle);
+            if (status.on &&
+                status.targetAngle == degree &&
+                status.targetForce == force)
+            {
+                return false;
+            }
+            command = CommandBuffer::WriteFinger(fingerNumber, force, degree);
+            status.targetAngle = degree;
+            status.targetForce = force;
+            status.on = true;
+            return true;
+        }
+
+        /// @return false if the finger is already released, command is untouched then
+        bool EncodeReleaseFinger(Finger finger, CommandBuffer& command)
+        {
+            FingerOperationStatus& status = fingerStatus[static_cast<int>(finger)];
+            if (!status.on) return false;
+            command = CommandBuffer::ReleaseFinger(static_cast<int>(finger));
+            status.on = false;
+            return true;
+        }
+
+        /// @brief Encode several targets and hand the changed ones to the device as one batch
+        void TransmitTargets(Device& device, const FingerTarget* targets, std::size_t count)
+        {
+            std::array<CommandBuffer, FINGER_TYPE_COUNT> commands;
+            std::size_t commandCount = 0;
+            for (std::size_t i = 0; i < count; i++)
+            {
+                const FingerTarget& target = targets[i];
+                bool changed = target.release
+                    ? EncodeReleaseFinger(target.finger, commands[commandCount])
+                    : EncodeFingerAngle(target.finger, target.angle, target.force, commands[commandCount]);
+                if (changed) commandCount++;
+                if (commandCount == commands.size())
+                {
+                    device.TransmitMessages(commands.data(), commandCount);
+                    commandCount = 0;
+                }
+            }
+            if (commandCount > 0)
+            {
+                device.TransmitMessages(commands.data(), commandCount);
+            }
+        }
+
+    private:
+        struct FingerOperationStatus
+        {
+            bool on = false;
+            int targetAngle = 0;
+            int targetForce = 0;
+        };
+
+        std::array<FingerOperationStatus, FINGER_TYPE_COUNT> fingerStatus;
+    };
+}
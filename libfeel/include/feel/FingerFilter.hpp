@@ -0,0 +1,291 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+namespace feel
+{
+    enum class FilterType
+    {
+        /// @brief Use the samples as they are
+        PassThrough,
+        /// @brief Adaptive low-pass, smooth when slow, little lag when fast
+        OneEuro,
+        /// @brief Critically damped spring following the samples
+        CriticallyDamped
+    };
+
+    /// @brief Settings of the filter applied to the samples of one finger
+    ///
+    /// All values are in degrees (0 - 180) and seconds.
+    struct FilterSettings
+    {
+        FilterType type = FilterType::OneEuro;
+        /// @brief One-Euro: cutoff frequency in Hz when the finger is not moving
+        float minCutoff = 1.5f;
+        /// @brief One-Euro: how much the cutoff rises with the speed of the finger
+        float beta = 0.05f;
+        /// @brief One-Euro: cutoff frequency in Hz used to smooth the speed
+        float derivativeCutoff = 1.0f;
+        /// @brief Critically damped: how fast the spring follows, in Hz
+        float frequency = 10.0f;
+
+        static FilterSettings PassThrough()
+        {
+            FilterSettings settings;
+            settings.type = FilterType::PassThrough;
+            return settings;
+        }
+
+        static FilterSettings OneEuro(float minCutoff, float beta, float derivativeCutoff = 1.0f)
+        {
+            FilterSettings settings;
+            settings.type = FilterType::OneEuro;
+            settings.minCutoff = minCutoff;
+            settings.beta = beta;
+            settings.derivativeCutoff = derivativeCutoff;
+            return settings;
+        }
+
+        static FilterSettings CriticallyDamped(float frequency)
+        {
+            FilterSettings settings;
+            settings.type = FilterType::CriticallyDamped;
+            settings.frequency = frequency;
+            return settings;
+        }
+    };
+
+    /// @brief Filters a fixed number of channels (fingers) at once
+    ///
+    /// State and settings are stored as structure of arrays and every
+    /// channel runs through the same branch-free arithmetic, so a batch
+    /// compiles to straight vectorizable loops. Each channel uses the
+    /// time that actually passed between its samples.
+    class FingerFilterBank
+    {
+    public:
+        explicit FingerFilterBank(std::size_t channelCount)
+        {
+            Resize(channelCount);
+        }
+
+        std::size_t ChannelCount() const
+        {
+            return value.size();
+        }
+
+        /// @brief Change the number of channels, new channels use the default FilterSettings
+        void Resize(std::size_t channelCount)
+        {
+            std::size_t previous = value.size();
+            for (std::vector<float>* column : { &value, &derivative, &initialized, &minCutoff, &beta,
+                &derivativeCutoff, &omega, &passWeight, &oneEuroWeight, &springWeight })
+            {
+                column->resize(channelCount, 0);
+            }
+            for (std::size_t i = previous; i < channelCount; i++)
+            {
+                Configure(i, FilterSettings());
+            }
+        }
+
+        void Configure(std::size_t channel, const FilterSettings& settings)
+        {
+            minCutoff[channel] = settings.minCutoff;
+            beta[channel] = settings.beta;
+            derivativeCutoff[channel] = settings.derivativeCutoff;
+            omega[channel] = 2 * PI * settings.frequency;
+            passWeight[channel] = settings.type == FilterType::PassThrough ? 1.0f : 0.0f;
+            oneEuroWeight[channel] = settings.type == FilterType::OneEuro ? 1.0f : 0.0f;
+            springWeight[channel] = settings.type == FilterType::CriticallyDamped ? 1.0f : 0.0f;
+            derivative[channel] = 0;
+        }
+
+        /// @brief Set the output of a channel, the next sample is taken as is
+        void Reset(std::size_t channel, float output)
+        {
+            value[channel] = output;
+            derivative[channel] = 0;
+            initialized[channel] = 0;
+        }
+
+        /// @brief Run one batch through the filters
+        /// @param input   One sample per channel
+        /// @param dt      Seconds since the previous sample of the channel
+        /// @param present 1 for channels with a new sample, 0 for channels to leave untouched
+        /// @note The arrays must hold ChannelCount() values and must not be the filter's own Outputs()
+        void Process(const float* input, const float* dt, const float* present)
+        {
+            Kernel(value.size(), input, dt, present,
+                minCutoff.data(), beta.data(), derivativeCutoff.data(), omega.data(),
+                passWeight.data(), oneEuroWeight.data(), springWeight.data(),
+                value.data(), derivative.data(), initialized.data());
+        }
+
+        float Output(std::size_t channel) const
+        {
+            return value[channel];
+        }
+
+        const float* Outputs() const
+        {
+            return value.data();
+        }
+
+    private:
+        static constexpr float PI = 3.14159265358979f;
+        static constexpr float MIN_DT = 1e-4f;
+
+        std::vector<float> value;
+        std::vector<float> derivative;
+        std::vector<float> initialized;
+        std::vector<float> minCutoff;
+        std::vector<float> beta;
+        std::vector<float> derivativeCutoff;
+        std::vector<float> omega;
+        std::vector<float> passWeight;
+        std::vector<float> oneEuroWeight;
+        std::vector<float> springWeight;
+
+        // Every pointer is a restricted parameter, so the compiler
+        // can vectorize without runtime alias checks.
+        static void Kernel(std::size_t count,
+            const float* __restrict input, const float* __restrict dt, const float* __restrict present,
+            const float* __restrict minimum, const float* __restrict speed, const float* __restrict derivativeMinimum,
+            const float* __restrict w, const float* __restrict pass, const float* __restrict oneEuroMix, const float* __restrict springMix,
+            float* __restrict v, float* __restrict d, float* __restrict init)
+        {
+            const float minDt = MIN_DT;
+            for (std::size_t i = 0; i < count; i++)
+            {
+                float x = input[i];
+                float t = dt[i];
+                t = t > minDt ? t : minDt;
+                float previous = v[i];
+                float previousDerivative = d[i];
+
+                // One-Euro
+                float dx = (x - previous) / t;
+                float dxHat = previousDerivative + Alpha(derivativeMinimum[i], t) * (dx - previousDerivative);
+                float cutoff = minimum[i] + speed[i] * std::fabs(dxHat);
+                float oneEuro = previous + Alpha(cutoff, t) * (x - previous);
+
+                // Critically damped spring, exact step towards x
+                float delta = previous - x;
+                float temp = (previousDerivative + w[i] * delta) * t;
+                float decay = ExpNegative(w[i] * t);
+                float springVelocity = (previousDerivative - w[i] * temp) * decay;
+                float spring = x + (delta + temp) * decay;
+
+                float filtered = pass[i] * x + oneEuroMix[i] * oneEuro + springMix[i] * spring;
+                float filteredDerivative = oneEuroMix[i] * dxHat + springMix[i] * springVelocity;
+
+                // The first sample after a reset is taken as is
+                filtered = init[i] * filtered + (1 - init[i]) * x;
+                filteredDerivative = init[i] * filteredDerivative;
+
+                v[i] = present[i] * filtered + (1 - present[i]) * previous;
+                d[i] = present[i] * filteredDerivative + (1 - present[i]) * previousDerivative;
+                init[i] = present[i] + (1 - present[i]) * init[i];
+            }
+        }
+
+        /// @brief Approximates exp(-x) for x >= 0, unlike std::exp this vectorizes
+        static float ExpNegative(float x)
+        {
+            return 1 / (1 + x + 0.48f * x * x + 0.235f * x * x * x);
+        }
+
+        static float Alpha(float cutoff, float dt)
+        {
+            float tau = 2 * PI * cutoff * dt;
+            return tau / (1 + tau);
+        }
+    };
+
+    /// @brief Collects samples for a FingerFilterBank and runs them through it as one batch
+    ///
+    /// Every channel has one slot per batch, a second sample for a channel
+    /// processes the batch first. Batches without any sample cost nothing.
+    class FingerFilterBatch
+    {
+    public:
+        explicit FingerFilterBatch(std::size_t channelCount) :
+            filters(channelCount),
+            input(channelCount, 0),
+            dt(channelCount, 0),
+            present(channelCount, 0),
+            pending(false)
+        {}
+
+        std::size_t ChannelCount() const
+        {
+            return filters.ChannelCount();
+        }
+
+        /// @brief Change the number of channels, see FingerFilterBank::Resize()
+        void Resize(std::size_t channelCount)
+        {
+            filters.Resize(channelCount);
+            input.resize(channelCount, 0);
+            dt.resize(channelCount, 0);
+            present.resize(channelCount, 0);
+        }
+
+        FingerFilterBank& Filters()
+        {
+            return filters;
+        }
+
+        const FingerFilterBank& Filters() const
+        {
+            return filters;
+        }
+
+        /// @brief Add a sample to the batch
+        /// @param seconds Time since the previous sample of the channel
+        void Queue(std::size_t channel, float angle, float seconds)
+        {
+            if (present[channel] != 0) Process();
+            input[channel] = angle;
+            dt[channel] = seconds;
+            present[channel] = 1;
+            pending = true;
+        }
+
+        /// @brief Drop the queued sample of a channel, e.g. after resetting its filter
+        void Discard(std::size_t channel)
+        {
+            present[channel] = 0;
+        }
+
+        /// @brief Run the queued samples through the filters
+        void Process()
+        {
+            if (!pending) return;
+            filters.Process(input.data(), dt.data(), present.data());
+            if (processedListener) processedListener(present.data());
+            std::fill(present.begin(), present.end(), 0.0f);
+            pending = false;
+        }
+
+        /// @brief Set a function to call after every processed batch
+        /// @param listener Gets one value per channel, 1 for the channels with a new output
+        void SetProcessedListener(std::function<void(const float*)> listener)
+        {
+            processedListener = listener;
+        }
+
+    private:
+        FingerFilterBank filters;
+        std::vector<float> input;
+        std::vector<float> dt;
+        std::vector<float> present;
+        bool pending;
+        std::function<void(const float*)> processedListener;
+    };
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <cstddef>
+
+namespace feel
+{
+    /// @brief A finger angle together with the time the device received it
+    struct FingerSample
+    {
+        std::chrono::steady_clock::time_point timestamp;
+        /// @brief The angle of the finger, ranges from 0 - 180
+        float angle;
+    };
+
+    /// @brief The most recent samples of a finger
+    ///
+    /// A fixed-size ring, pushing never allocates and
+    /// the oldest samples are overwritten.
+    class FingerHistory
+    {
+    public:
+        static constexpr std::size_t CAPACITY = 64;
+
+        FingerHistory() :
+            next(0),
+            count(0)
+        {}
+
+        void Push(const FingerSample& sample)
+        {
+            samples[next] = sample;
+            next = (next + 1) % CAPACITY;
+            if (count < CAPACITY) count++;
+        }
+
+        void Clear()
+        {
+            next = 0;
+            count = 0;
+        }
+
+        /// @brief The number of samples stored
+        std::size_t Size() const
+        {
+            return count;
+        }
+
+        bool Empty() const
+        {
+            return count == 0;
+        }
+
+        /// @brief Access a sample by age
+        /// @param age 0 is the latest sample, Size() - 1 the oldest one
+        const FingerSample& operator[](std::size_t age) const
+        {
+            return samples[(next + CAPACITY - 1 - age) % CAPACITY];
+        }
+
+        /// @pre !Empty()
+        const FingerSample& Latest() const
+        {
+            return (*this)[0];
+        }
+
+        /// @brief The velocity in degrees per second between the latest two samples
+        ///
+        /// Samples received in the same read share their timestamp,
+        /// those are skipped to get a meaningful time difference.
+        float Velocity() const
+        {
+            if (count < 2) return 0;
+            std::size_t older = NextDistinct(0);
+            if (older == count) return 0;
+            return Slope((*this)[older], (*this)[0]);
+        }
+
+        /// @brief The acceleration in degrees per second squared over the latest three samples
+        float Acceleration() const
+        {
+            if (count < 3) return 0;
+            std::size_t middle = NextDistinct(0);
+            if (middle == count) return 0;
+            std::size_t oldest = NextDistinct(middle);
+            if (oldest == count) return 0;
+            float v1 = Slope((*this)[middle], (*this)[0]);
+            float v0 = Slope((*this)[oldest], (*this)[middle]);
+            float dt = Seconds((*this)[oldest].timestamp, (*this)[0].timestamp) * 0.5f;
+            return (v1 - v0) / dt;
+        }
+
+    private:
+        // Bounds the search for distinct timestamps, so queries stay O(1)
+        static constexpr std::size_t MAX_SAME_TIMESTAMP = 8;
+
+        std::array<FingerSample, CAPACITY> samples;
+        std::size_t next;
+        std::size_t count;
+
+        /// @return the age of the first sample older than the one at age, or count
+        std::size_t NextDistinct(std::size_t age) const
+        {
+            auto timestamp = (*this)[age].timestamp;
+            std::size_t limit = age + MAX_SAME_TIMESTAMP < count ? age + MAX_SAME_TIMESTAMP + 1 : count;
+            for (std::size_t i = age + 1; i < limit; i++)
+            {
+                if ((*this)[i].timestamp != timestamp) return i;
+            }
+            return count;
+        }
+
+        static float Seconds(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+        {
+            return std::chrono::duration<float>(to - from).count();
+        }
+
+        static float Slope(const FingerSample& from, const FingerSample& to)
+        {
+            return (to.angle - from.angle) / Seconds(from.timestamp, to.timestamp);
+        }
+    };
+}
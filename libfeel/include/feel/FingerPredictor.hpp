@@ -0,0 +1,301 @@
+#pragma once
+#include "feel/FingerHistory.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace feel
+{
+    enum class PredictionModel
+    {
+        /// @brief Continue with the velocity of the latest two samples
+        ConstantVelocity,
+        /// @brief Continue with the velocity and acceleration of the latest three samples
+        ConstantAcceleration,
+        /// @brief Angle and velocity estimated by a Kalman filter over all samples
+        Kalman
+    };
+
+    /// @brief Settings of Feel::GetPredictedFingerAngle()
+    ///
+    /// All values are in degrees (0 - 180) and seconds.
+    struct PredictionSettings
+    {
+        PredictionModel model = PredictionModel::ConstantVelocity;
+        /// @brief How far beyond the latest sample a prediction may reach, later targets are clamped
+        float maxHorizon = 0.1f;
+        /// @brief Kalman: variance of the unmodeled acceleration, in degrees² / s⁴
+        float processNoise = 1.0e6f;
+        /// @brief Kalman: variance of the measured angles, in degrees²
+        float measurementNoise = 1.0f;
+
+        static PredictionSettings ConstantVelocity()
+        {
+            return PredictionSettings();
+        }
+
+        static PredictionSettings ConstantAcceleration()
+        {
+            PredictionSettings settings;
+            settings.model = PredictionModel::ConstantAcceleration;
+            return settings;
+        }
+
+        static PredictionSettings Kalman(float processNoise, float measurementNoise)
+        {
+            PredictionSettings settings;
+            settings.model = PredictionModel::Kalman;
+            settings.processNoise = processNoise;
+            settings.measurementNoise = measurementNoise;
+            return settings;
+        }
+    };
+
+    /// @brief How far past predictions were off, see Feel::GetPredictionError()
+    struct PredictionError
+    {
+        /// @brief The number of predictions that were checked
+        std::uint64_t count = 0;
+        /// @brief In degrees
+        float meanAbsolute = 0;
+        float rootMeanSquare = 0;
+        float maxAbsolute = 0;
+        /// @brief How far ahead of the latest sample the predictions were on average, in seconds
+        float meanHorizon = 0;
+    };
+
+    /// @brief Extrapolates the angle of one finger from its samples
+    ///
+    /// Update() must see every sample pushed into the history. The predictions
+    /// made with Predict() are kept (up to PENDING_CAPACITY) and compared with
+    /// the angle the finger really had at the target time once a later sample
+    /// arrived, the actual angle is interpolated between the two samples around it.
+    class FingerPredictor
+    {
+    public:
+        static constexpr std::size_t PENDING_CAPACITY = 16;
+
+        FingerPredictor()
+        {
+            Reset();
+        }
+
+        /// @brief Use other settings, clears the Kalman state and the error statistics
+        void Configure(const PredictionSettings& newSettings)
+        {
+            settings = newSettings;
+            Reset();
+        }
+
+        const PredictionSettings& GetSettings() const
+        {
+            return settings;
+        }
+
+        /// @brief Forget the samples and the error statistics, e.g. for a new session
+        void Reset()
+        {
+            initialized = false;
+            angle = 0;
+            velocity = 0;
+            covariance = { 0, 0, 0, 0 };
+            pendingCount = 0;
+            ResetError();
+        }
+
+        void ResetError()
+        {
+            errorCount = 0;
+            absoluteSum = 0;
+            squareSum = 0;
+            maxAbsolute = 0;
+            horizonSum = 0;
+        }
+
+        /// @brief Take the latest sample of the history into account
+        void Update(const FingerHistory& history)
+        {
+            const FingerSample& sample = history.Latest();
+            if (pendingCount > 0 && history.Size() > 1)
+            {
+                CheckPredictions(history[1], sample);
+            }
+            if (settings.model == PredictionModel::Kalman)
+            {
+                KalmanUpdate(sample);
+            }
+        }
+
+        /// @brief The angle the finger is expected to have at target
+        /// @pre !history.Empty()
+        float Predict(const FingerHistory& history, std::chrono::steady_clock::time_point target)
+        {
+            const FingerSample& latest = history.Latest();
+            float horizon = std::min(std::max(Seconds(latest.timestamp, target), 0.0f), settings.maxHorizon);
+            float predicted;
+            switch (settings.model)
+            {
+                case PredictionModel::ConstantAcceleration:
+                    predicted = latest.angle + history.Velocity() * horizon + 0.5f * history.Acceleration() * horizon * horizon;
+                    break;
+                case PredictionModel::Kalman:
+                    // The state is at the time of the latest sample
+                    predicted = initialized ? angle + velocity * horizon : latest.angle;
+                    break;
+                default:
+                    predicted = latest.angle + history.Velocity() * horizon;
+                    break;
+            }
+            predicted = std::min(std::max(predicted, 0.0f), 180.0f);
+            if (target > latest.timestamp)
+            {
+                Remember(target, predicted, horizon);
+            }
+            return predicted;
+        }
+
+        PredictionError GetError() const
+        {
+            PredictionError error;
+            error.count = errorCount;
+            if (errorCount == 0) return error;
+            error.meanAbsolute = static_cast<float>(absoluteSum / errorCount);
+            error.rootMeanSquare = static_cast<float>(std::sqrt(squareSum / errorCount));
+            error.maxAbsolute = maxAbsolute;
+            error.meanHorizon = static_cast<float>(horizonSum / errorCount);
+            return error;
+        }
+
+    private:
+        struct Pending
+        {
+            std::chrono::steady_clock::time_point target;
+            float angle;
+            float horizon;
+        };
+
+        PredictionSettings settings;
+
+        // Kalman state: angle and velocity at stateTime, covariance row major
+        bool initialized;
+        std::chrono::steady_clock::time_point stateTime;
+        float angle;
+        float velocity;
+        std::array<float, 4> covariance;
+
+        // Predictions whose target was not reached by a sample yet, unordered
+        std::array<Pending, PENDING_CAPACITY> pending;
+        std::size_t pendingCount;
+
+        std::uint64_t errorCount;
+        double absoluteSum;
+        double squareSum;
+        float maxAbsolute;
+        double horizonSum;
+
+        void Remember(std::chrono::steady_clock::time_point target, float predicted, float horizon)
+        {
+            // Asking again for the same target replaces the earlier prediction
+            for (std::size_t i = 0; i < pendingCount; i++)
+            {
+                if (pending[i].target == target)
+                {
+                    pending[i] = Pending{ target, predicted, horizon };
+                    return;
+                }
+            }
+            if (pendingCount < PENDING_CAPACITY)
+            {
+                pending[pendingCount++] = Pending{ target, predicted, horizon };
+                return;
+            }
+            // Full, replace the prediction for the earliest target
+            std::size_t earliest = 0;
+            for (std::size_t i = 1; i < pendingCount; i++)
+            {
+                if (pending[i].target < pending[earliest].target) earliest = i;
+            }
+            pending[earliest] = Pending{ target, predicted, horizon };
+        }
+
+        void CheckPredictions(const FingerSample& previous, const FingerSample& latest)
+        {
+            float span = Seconds(previous.timestamp, latest.timestamp);
+            std::size_t i = 0;
+            while (i < pendingCount)
+            {
+                const Pending& prediction = pending[i];
+                if (prediction.target > latest.timestamp)
+                {
+                    i++;
+                    continue;
+                }
+                float actual = latest.angle;
+                if (span > 0 && prediction.target > previous.timestamp)
+                {
+                    float t = Seconds(previous.timestamp, prediction.target) / span;
+                    actual = previous.angle + (latest.angle - previous.angle) * t;
+                }
+                float error = std::fabs(prediction.angle - actual);
+                errorCount++;
+                absoluteSum += error;
+                squareSum += double(error) * error;
+                maxAbsolute = std::max(maxAbsolute, error);
+                horizonSum += prediction.horizon;
+                pending[i] = pending[--pendingCount];
+            }
+        }
+
+        void KalmanUpdate(const FingerSample& sample)
+        {
+            if (!initialized)
+            {
+                initialized = true;
+                stateTime = sample.timestamp;
+                angle = sample.angle;
+                velocity = 0;
+                // Nothing is known about the velocity yet
+                covariance = { settings.measurementNoise, 0, 0, 1.0e4f };
+                return;
+            }
+            float dt = Seconds(stateTime, sample.timestamp);
+            if (dt > 0)
+            {
+                // Predict with constant velocity, the acceleration is white noise
+                angle += velocity * dt;
+                float p00 = covariance[0] + dt * (covariance[1] + covariance[2]) + dt * dt * covariance[3];
+                float p01 = covariance[1] + dt * covariance[3];
+                float p10 = covariance[2] + dt * covariance[3];
+                float p11 = covariance[3];
+                float q = settings.processNoise;
+                p00 += q * dt * dt * dt * dt * 0.25f;
+                p01 += q * dt * dt * dt * 0.5f;
+                p10 += q * dt * dt * dt * 0.5f;
+                p11 += q * dt * dt;
+                covariance = { p00, p01, p10, p11 };
+                stateTime = sample.timestamp;
+            }
+            // Only the angle is measured
+            float s = covariance[0] + settings.measurementNoise;
+            float k0 = covariance[0] / s;
+            float k1 = covariance[2] / s;
+            float residual = sample.angle - angle;
+            angle += k0 * residual;
+            velocity += k1 * residual;
+            covariance = {
+                (1 - k0) * covariance[0],
+                (1 - k0) * covariance[1],
+                covariance[2] - k1 * covariance[0],
+                covariance[3] - k1 * covariance[1]
+            };
+        }
+
+        static float Seconds(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+        {
+            return std::chrono::duration<float>(to - from).count();
+        }
+    };
+}
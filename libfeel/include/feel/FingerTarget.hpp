@@ -0,0 +1,27 @@
+#pragma once
+#include "feel/Finger.hpp"
+
+namespace feel
+{
+    /// @brief What a finger should do, used to update several fingers at once
+    struct FingerTarget
+    {
+        Finger finger;
+        /// @brief The angle to move the finger to (0-180)
+        float angle;
+        /// @brief How much force should be applied (0-99)
+        int force;
+        /// @brief Release the finger instead of moving it, angle and force are ignored
+        bool release;
+
+        static FingerTarget Move(Finger finger, float angle, int force)
+        {
+            return FingerTarget{ finger, angle, force, false };
+        }
+
+        static FingerTarget Release(Finger finger)
+        {
+            return FingerTarget{ finger, 0, 0, true };
+        }
+    };
+}
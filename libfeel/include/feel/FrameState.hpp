@@ -0,0 +1,40 @@
+#pragma once
+#include "feel/Finger.hpp"
+#include "feel/CalibrationData.hpp"
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+namespace feel
+{
+    /// @brief Everything a consumer needs of one parsed frame, as plain data
+    ///
+    /// Taken by ParseMessages(), see Feel::GetFrameSnapshot() and
+    /// Feel::StartPublishing(). The layout is fixed, it is shared with other processes.
+    /// Timestamps are microseconds of std::chrono::steady_clock, which is the
+    /// same clock for all processes on a machine.
+    struct FrameState
+    {
+        /// @brief Counts the published frames, starting at 1
+        std::uint64_t frame;
+        /// @brief When the newest message of the frame was received, or when it was taken if there was none
+        std::int64_t timestampMicroseconds;
+        /// @brief See feel::FeelStatus
+        std::int32_t status;
+        /// @brief FINGER_TYPE_COUNT of the publisher
+        std::int32_t fingerCount;
+        /// @brief The filtered angles, see Feel::GetFingerAngle(), indexed by feel::Finger
+        std::array<float, FINGER_TYPE_COUNT> angles;
+        /// @brief When the latest sample of each finger was received, 0 if there was none
+        std::array<std::int64_t, FINGER_TYPE_COUNT> sampleTimestamps;
+        /// @brief The calibration data in use
+        std::array<FingerCalibrationData, FINGER_TYPE_COUNT> calibration;
+
+        static std::int64_t Microseconds(std::chrono::steady_clock::time_point time)
+        {
+            return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+        }
+    };
+
+    static_assert(sizeof(FrameState) == 24 + FINGER_TYPE_COUNT * (4 + 8 + 8), "FrameState must not have hidden padding");
+}
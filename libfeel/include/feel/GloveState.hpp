@@ -0,0 +1,499 @@
+#pragma once
+#include "feel/Device.hpp"
+#include "feel/Finger.hpp"
+#include "feel/IncomingMessage.hpp"
+#include "feel/MessageBatch.hpp"
+#include "feel/MessageTypeTable.hpp"
+#include "feel/MessageFields.hpp"
+#include "feel/FeelStatus.hpp"
+#include "feel/CalibrationData.hpp"
+#include "feel/NormalizationSweep.hpp"
+#include "feel/CommandBuffer.hpp"
+#include "feel/FingerHistory.hpp"
+#include "feel/FingerFilter.hpp"
+#include "feel/FingerPredictor.hpp"
+#include "feel/LatencyHistogram.hpp"
+#include "feel/Log.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace feel
+{
+    /// @brief The state of one glove and the parsing of its messages
+    ///
+    /// Feel owns one, HandManager one per hand. Parsing updates the status,
+    /// the calibration, the sample histories and the latency measurements and
+    /// queues the samples into a FingerFilterBatch shared with other gloves,
+    /// starting at the glove's first channel.
+    ///
+    /// Not thread-safe apart from GetStatus() and the latency histograms,
+    /// the owner serializes the calls.
+    class GloveState
+    {
+    public:
+        /// @param device       The glove's device, not owned
+        /// @param filters      Gets the samples of the fingers, one channel per finger
+        /// @param firstChannel The channel of HAND_0_THUMB_0 in filters
+        GloveState(Device* device, FingerFilterBatch& filters, std::size_t firstChannel) :
+            device(device),
+            filters(filters),
+            firstChannel(firstChannel),
+            status(FeelStatus::DeviceDisconnected)
+        {
+            calibrationData.angles.fill(FingerCalibrationData{ 0, 180 });
+            observedRange.fill(FingerCalibrationData{ std::numeric_limits<int>::max(), std::numeric_limits<int>::min() });
+        }
+
+        GloveState(const GloveState&) = delete;
+        GloveState& operator=(const GloveState&) = delete;
+
+        Device& GetDevice()
+        {
+            return *device;
+        }
+
+        std::size_t Channel(int fingerIndex) const
+        {
+            return firstChannel + static_cast<std::size_t>(fingerIndex);
+        }
+
+        FeelStatus GetStatus() const
+        {
+            return status;
+        }
+
+        /// @brief Follow the device status while no normalization or session runs
+        void UpdateStatus()
+        {
+            switch (status)
+            {
+                case FeelStatus::DeviceDisconnected:
+                case FeelStatus::DeviceConnecting:
+                case FeelStatus::DeviceConnected:
+                    switch (device->GetStatus())
+                    {
+                        case DeviceStatus::Disconnected:
+                            SetStatus(FeelStatus::DeviceDisconnected);
+                            break;
+                        case DeviceStatus::Connecting:
+                            SetStatus(FeelStatus::DeviceConnecting);
+                            break;
+                        case DeviceStatus::Connected:
+                            SetStatus(FeelStatus::DeviceConnected);
+                            break;
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        void StartNormalization()
+        {
+            calibrationData.angles.fill(FingerCalibrationData{ std::numeric_limits<int>::max(), std::numeric_limits<int>::min() });
+            device->TransmitMessage(CommandBuffer::StartNormalization());
+            SetStatus(FeelStatus::Normalization);
+        }
+
+        void BeginSession()
+        {
+            device->TransmitMessage(CommandBuffer::BeginSession());
+            for (int i = 0; i < FINGER_TYPE_COUNT; i++)
+            {
+                filters.Filters().Reset(Channel(i), 0);
+                filters.Discard(Channel(i));
+                histories[i].Clear();
+                predictors[i].Reset();
+            }
+            observedRange.fill(FingerCalibrationData{ std::numeric_limits<int>::max(), std::numeric_limits<int>::min() });
+            observedSamples.fill(0);
+            SetStatus(FeelStatus::Active);
+        }
+
+        void EndSession()
+        {
+            device->TransmitMessage(CommandBuffer::EndSession());
+            SetStatus(FeelStatus::DeviceConnected);
+            UpdateStatus();
+        }
+
+        void SetCalibrationData(const CalibrationData& data)
+        {
+            calibrationData = data;
+        }
+
+        const CalibrationData& GetCalibrationData() const
+        {
+            return calibrationData;
+        }
+
+        /// @brief See Feel::CheckCalibration()
+        CalibrationCheck CheckCalibration(std::uint32_t minimumSamples, float tolerance) const
+        {
+            bool pending = false;
+            for (int i = 0; i < FINGER_TYPE_COUNT; i++)
+            {
+                if (observedSamples[i] < minimumSamples) pending = true;
+                if (observedSamples[i] == 0) continue;
+                const FingerCalibrationData& range = calibrationData.angles[i];
+                float margin = tolerance * (range.max - range.min);
+                if (observedRange[i].min < range.min - margin || observedRange[i].max > range.max + margin)
+                {
+                    return CalibrationCheck::Invalid;
+                }
+            }
+            return pending ? CalibrationCheck::Pending : CalibrationCheck::Valid;
+        }
+
+        const FingerHistory& GetFingerHistory(int fingerIndex) const
+        {
+            return histories[fingerIndex];
+        }
+
+        FingerPredictor& GetPredictor(int fingerIndex)
+        {
+            return predictors[fingerIndex];
+        }
+
+        const FingerPredictor& GetPredictor(int fingerIndex) const
+        {
+            return predictors[fingerIndex];
+        }
+
+        /// @brief See Feel::SetInstrumentation()
+        void SetInstrumentation(bool enabled)
+        {
+            device->SetInstrumentation(enabled);
+            if (enabled)
+            {
+                consumeLatency.Reset();
+                roundTripLatency.Reset();
+                pendingProbes.fill(PendingProbe());
+            }
+            instrumented = enabled;
+        }
+
+        /// @brief See Feel::SendLatencyProbe()
+        std::uint16_t SendLatencyProbe()
+        {
+            std::uint16_t sequence = nextProbeSequence++;
+            PendingProbe& probe = pendingProbes[sequence % pendingProbes.size()];
+            probe.sequence = sequence;
+            probe.sent = std::chrono::steady_clock::now();
+            device->TransmitMessage(CommandBuffer::LatencyProbe(sequence));
+            return sequence;
+        }
+
+        /// @brief May be called from any thread
+        LatencyHistogramData GetLatencyHistogram(LatencyStage stage) const
+        {
+            switch (stage)
+            {
+                case LatencyStage::Send:
+                    return device->GetSendLatency();
+                case LatencyStage::Consume:
+                    return consumeLatency.Data();
+                case LatencyStage::RoundTrip:
+                    return roundTripLatency.Data();
+            }
+            return LatencyHistogramData();
+        }
+
+        /// @brief Whether messages with the identifier can get a handler
+        static bool IsCustomIdentifier(const char* identifier)
+        {
+            if (std::strlen(identifier) != 2) return false;
+            std::size_t index = MessageTypeTable::Index(identifier[0], identifier[1]);
+            return index != MessageTypeTable::INVALID_INDEX && MessageTypeTable::Lookup(index) == IncomingMessage::Unknown;
+        }
+
+        /// @brief See Feel::RegisterMessageHandler()
+        bool RegisterMessageHandler(const char* identifier, std::function<void(const ReceivedMessage&)> handler)
+        {
+            if (!IsCustomIdentifier(identifier)) return false;
+            std::size_t index = MessageTypeTable::Index(identifier[0], identifier[1]);
+            if (messageHandlers.empty())
+            {
+                // Only paid for once a handler is registered
+                messageHandlers.resize(MessageTypeTable::SIZE);
+            }
+            messageHandlers[index] = handler;
+            return true;
+        }
+
+        std::uint64_t GetUnknownMessageCount() const
+        {
+            return unknownMessages;
+        }
+
+        RejectedFrameCounts GetRejectedFrameCounts() const
+        {
+            return rejectedFrames;
+        }
+
+        /// @brief Gets the text of every Debug message, Logger::Default() gets them if it is empty
+        void SetDebugLogCallback(std::function<void(const char*, std::size_t)> callback)
+        {
+            debugLogCallback = callback;
+        }
+
+        void SetNormalizationLogging(bool enabled)
+        {
+            normalizationLogging = enabled;
+        }
+
+        void SetFingerUpdateHandler(std::function<void(Finger, const FingerSample&)> handler)
+        {
+            fingerUpdateHandler = handler;
+        }
+
+        void SetNormalizationSampleHandler(std::function<void(Finger, int, int)> handler)
+        {
+            normalizationSampleHandler = handler;
+        }
+
+        void SetEndNormalizationHandler(std::function<void()> handler)
+        {
+            endNormalizationHandler = handler;
+        }
+
+        void SetStatusChangeHandler(std::function<void(FeelStatus)> handler)
+        {
+            statusChangeHandler = handler;
+        }
+
+        /// @brief Take the device's messages into batch and parse them
+        ///
+        /// The samples stay queued in the filter batch until the owner processes it.
+        void ParseMessages(MessageBatch& batch)
+        {
+            UpdateStatus();
+            device->DrainMessages(batch);
+            for (const ReceivedMessage& received : batch)
+            {
+                ParseMessage(received);
+            }
+        }
+
+        /// @brief Report the new filter outputs of the glove's channels
+        ///
+        /// Call it from the FingerFilterBatch's processed listener.
+        /// @param present The values passed to the listener
+        void FinishFilterBatch(const float* present)
+        {
+            if (!instrumented && !fingerUpdateHandler) return;
+            present += firstChannel;
+            if (instrumented)
+            {
+                // From here on the new samples can be read
+                auto now = std::chrono::steady_clock::now();
+                for (int i = 0; i < FINGER_TYPE_COUNT; i++)
+                {
+                    if (present[i] == 0) continue;
+                    consumeLatency.Record(now - histories[i].Latest().timestamp);
+                }
+            }
+            if (fingerUpdateHandler)
+            {
+                for (int i = 0; i < FINGER_TYPE_COUNT; i++)
+                {
+                    if (present[i] == 0) continue;
+                    fingerUpdateHandler(static_cast<Finger>(i), histories[i].Latest());
+                }
+            }
+        }
+
+    private:
+        struct PendingProbe
+        {
+            std::uint16_t sequence = 0;
+            std::chrono::steady_clock::time_point sent;
+        };
+
+        Device* device;
+        FingerFilterBatch& filters;
+        const std::size_t firstChannel;
+        std::atomic<FeelStatus> status;
+        CalibrationData calibrationData;
+        std::array<FingerHistory, FINGER_TYPE_COUNT> histories;
+        std::array<FingerPredictor, FINGER_TYPE_COUNT> predictors;
+        // The raw angles received since BeginSession(), for CheckCalibration()
+        std::array<FingerCalibrationData, FINGER_TYPE_COUNT> observedRange;
+        std::array<std::uint32_t, FINGER_TYPE_COUNT> observedSamples = {};
+
+        std::function<void(const char*, std::size_t)> debugLogCallback;
+        std::function<void(Finger, const FingerSample&)> fingerUpdateHandler;
+        std::function<void(Finger, int, int)> normalizationSampleHandler;
+        std::function<void()> endNormalizationHandler;
+        std::function<void(FeelStatus)> statusChangeHandler;
+        // Indexed by MessageTypeTable::Index(), empty until a handler is registered
+        std::vector<std::function<void(const ReceivedMessage&)>> messageHandlers;
+        std::uint64_t unknownMessages = 0;
+        RejectedFrameCounts rejectedFrames;
+        bool normalizationLogging = false;
+
+        bool instrumented = false;
+        LatencyHistogram consumeLatency;
+        LatencyHistogram roundTripLatency;
+        // Probes whose echo is still missing, older ones are overwritten
+        std::array<PendingProbe, 16> pendingProbes;
+        std::uint16_t nextProbeSequence = 0;
+
+        void ParseMessage(const ReceivedMessage& received)
+        {
+            if (received.length < 2) return;
+            std::size_t index = MessageTypeTable::Index(received.data[0], received.data[1]);
+            switch (MessageTypeTable::Lookup(index))
+            {
+                case IncomingMessage::DebugLog:
+                {
+                    DebugLog(received.data + 2, received.length - 2);
+                } break;
+                case IncomingMessage::FingerUpdate:
+                {
+                    MessageFields fields(received);
+                    int fingerIndex = fields.Finger();
+                    int rawAngle = fields.Decimal();
+                    if (fields.Error() != FrameError::None)
+                    {
+                        rejectedFrames.Count(fields.Error());
+                        break;
+                    }
+                    ObserveRawAngle(fingerIndex, rawAngle);
+                    FingerSample sample{ received.timestamp, NormalizeAngle(fingerIndex, rawAngle) };
+                    QueueFilterSample(fingerIndex, sample);
+                    histories[fingerIndex].Push(sample);
+                    predictors[fingerIndex].Update(histories[fingerIndex]);
+                } break;
+                case IncomingMessage::NormalizationData:
+                {
+                    MessageFields fields(received);
+                    int fingerIndex = fields.Finger();
+                    int realAngle = fields.Decimal(3);
+                    int fingerAngle = fields.Decimal();
+                    if (fields.Error() != FrameError::None)
+                    {
+                        rejectedFrames.Count(fields.Error());
+                        break;
+                    }
+                    AddNormalizationSample(fingerIndex, realAngle, fingerAngle);
+                } break;
+                case IncomingMessage::NormalizationBulk:
+                {
+                    NormalizationSweep sweep;
+                    FrameError error = NormalizationSweep::Decode(received.data, received.length, sweep);
+                    if (error != FrameError::None)
+                    {
+                        rejectedFrames.Count(error);
+                        break;
+                    }
+                    for (std::size_t i = 0; i < sweep.count; i++)
+                    {
+                        AddNormalizationSample(sweep.finger, sweep.firstRealAngle + static_cast<int>(i), sweep.Angle(i));
+                    }
+                } break;
+                case IncomingMessage::EndNormalization:
+                {
+                    if (status == FeelStatus::Normalization)
+                    {
+                        SetStatus(FeelStatus::DeviceConnected);
+                    }
+                    if (endNormalizationHandler)
+                    {
+                        endNormalizationHandler();
+                    }
+                } break;
+                case IncomingMessage::ProbeEcho:
+                {
+                    MessageFields fields(received);
+                    auto sequence = static_cast<std::uint16_t>(fields.Hex());
+                    if (fields.Error() != FrameError::None)
+                    {
+                        rejectedFrames.Count(fields.Error());
+                        break;
+                    }
+                    PendingProbe& probe = pendingProbes[sequence % pendingProbes.size()];
+                    if (probe.sequence != sequence || probe.sent == std::chrono::steady_clock::time_point()) break;
+                    roundTripLatency.Record(received.timestamp - probe.sent);
+                    probe.sent = std::chrono::steady_clock::time_point();
+                } break;
+                case IncomingMessage::Unknown:
+                {
+                    if (index < messageHandlers.size() && messageHandlers[index])
+                    {
+                        messageHandlers[index](received);
+                        break;
+                    }
+                    unknownMessages++;
+                } break;
+            }
+        }
+
+        void SetStatus(FeelStatus newStatus)
+        {
+            FeelStatus previous = status.exchange(newStatus);
+            if (previous != newStatus && statusChangeHandler)
+            {
+                statusChangeHandler(newStatus);
+            }
+        }
+
+        void DebugLog(const char* text, std::size_t length)
+        {
+            if (debugLogCallback)
+            {
+                debugLogCallback(text, length);
+                return;
+            }
+            Logger::Default().Write(LogLevel::Debug, text, length);
+        }
+
+        void AddNormalizationSample(int fingerIndex, int realAngle, int angle)
+        {
+            if (normalizationLogging)
+            {
+                char line[64];
+                int length = std::snprintf(line, sizeof(line), "Init Finger: %02x Real Angle: %03d Angle: %d", fingerIndex, realAngle, angle);
+                DebugLog(line, static_cast<std::size_t>(length));
+            }
+            FingerCalibrationData& data = calibrationData.angles[fingerIndex];
+            data.min = std::min(data.min, angle);
+            data.max = std::max(data.max, angle);
+            if (normalizationSampleHandler)
+            {
+                normalizationSampleHandler(static_cast<Finger>(fingerIndex), realAngle, angle);
+            }
+        }
+
+        void ObserveRawAngle(int fingerIndex, int rawAngle)
+        {
+            FingerCalibrationData& range = observedRange[fingerIndex];
+            range.min = std::min(range.min, rawAngle);
+            range.max = std::max(range.max, rawAngle);
+            observedSamples[fingerIndex]++;
+        }
+
+        void QueueFilterSample(int fingerIndex, const FingerSample& sample)
+        {
+            const FingerHistory& history = histories[fingerIndex];
+            float dt = history.Empty() ? 0 : std::chrono::duration<float>(sample.timestamp - history.Latest().timestamp).count();
+            filters.Queue(Channel(fingerIndex), sample.angle, dt);
+        }
+
+        /// @brief Map a raw device angle to 0 - 180 using the calibration data
+        float NormalizeAngle(int fingerIndex, float angle) const
+        {
+            const FingerCalibrationData& data = calibrationData.angles[fingerIndex];
+            return (angle - data.min) / (data.max - data.min) * 180;
+        }
+    };
+}
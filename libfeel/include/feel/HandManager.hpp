@@ -0,0 +1,394 @@
+#pragma once
+#include "feel/Device.hpp"
+#include "feel/Finger.hpp"
+#include "feel/GloveState.hpp"
+#include "feel/FeelStatus.hpp"
+#include "feel/CalibrationData.hpp"
+#include "feel/FingerTarget.hpp"
+#include "feel/FingerCommandEncoder.hpp"
+#include "feel/FingerHistory.hpp"
+#include "feel/FingerFilter.hpp"
+#include "feel/Log.hpp"
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace feel
+{
+    /// @brief Drives several gloves (hands) from one place
+    ///
+    /// Every hand has its own device, fingers are addressed by the hand index
+    /// and a feel::Finger. The state of all fingers of all hands is kept in one
+    /// table of channels (hand * FINGER_TYPE_COUNT + finger), which ParseMessages()
+    /// fills in a single pass. Every hand is parsed by its own GloveState, the
+    /// same as Feel uses, and all hands share one FingerFilterBatch.
+    /// Devices report when they received something,
+    /// so a pass only visits the hands that actually have new messages.
+    ///
+    /// Apart from the devices' own threads, a HandManager must be used from one thread.
+    class HandManager
+    {
+    public:
+        static constexpr std::size_t MAX_HANDS = 64;
+
+        HandManager() :
+            filters(0),
+            readyHands(0),
+            polledHands(0)
+        {
+            hands.reserve(MAX_HANDS);
+            filters.SetProcessedListener([this](const float* present)
+            {
+                for (auto& hand : hands)
+                {
+                    hand->state.FinishFilterBatch(present);
+                }
+            });
+        }
+
+        HandManager(const HandManager&) = delete;
+        HandManager& operator=(const HandManager&) = delete;
+
+        ~HandManager()
+        {
+            for (auto& hand : hands)
+            {
+                hand->device->SetReceiveListener(nullptr);
+                delete hand->device;
+            }
+        }
+
+        /// @brief Add a hand driven by the given device
+        /// @param device The device of the hand, it is deleted in the destructor.
+        /// @return The index of the new hand
+        /// @pre HandCount() < MAX_HANDS
+        std::size_t AddHand(Device* device)
+        {
+            assert(hands.size() < MAX_HANDS);
+            std::size_t index = hands.size();
+            filters.Resize((index + 1) * FINGER_TYPE_COUNT);
+            hands.emplace_back(new Hand(device, filters, index));
+            GloveState& state = hands.back()->state;
+            state.SetDebugLogCallback([this, index](const char* text, std::size_t length)
+            {
+                if (debugLogCallback)
+                {
+                    debugLogCallback(index, std::string(text, length));
+                    return;
+                }
+                Logger::Default().Format(LogLevel::Debug, "[%u] %.*s", static_cast<unsigned>(index), static_cast<int>(length), text);
+            });
+            for (auto& registered : messageHandlers)
+            {
+                RegisterHandHandler(state, index, registered.first.c_str(), registered.second);
+            }
+
+            std::uint64_t bit = std::uint64_t(1) << index;
+            bool notifies = device->SetReceiveListener([this, bit]()
+            {
+                readyHands.fetch_or(bit, std::memory_order_release);
+            });
+            if (!notifies)
+            {
+                // Looked at in every pass instead
+                polledHands |= bit;
+            }
+            return index;
+        }
+
+        std::size_t HandCount() const
+        {
+            return hands.size();
+        }
+
+        /// @brief The number of entries in the state table
+        std::size_t ChannelCount() const
+        {
+            return hands.size() * FINGER_TYPE_COUNT;
+        }
+
+        /// @brief The index of a finger in the state table
+        static std::size_t Channel(std::size_t hand, Finger finger)
+        {
+            return hand * FINGER_TYPE_COUNT + static_cast<std::size_t>(finger);
+        }
+
+        Device& GetDevice(std::size_t hand)
+        {
+            return *hands[hand]->device;
+        }
+
+        void Connect(std::size_t hand, const char* deviceName)
+        {
+            hands[hand]->device->Connect(deviceName);
+            hands[hand]->state.UpdateStatus();
+        }
+
+        void Disconnect(std::size_t hand)
+        {
+            hands[hand]->device->Disconnect();
+            hands[hand]->state.UpdateStatus();
+        }
+
+        /// @brief Get the current feel::FeelStatus of a hand
+        FeelStatus GetStatus(std::size_t hand)
+        {
+            hands[hand]->state.UpdateStatus();
+            return hands[hand]->state.GetStatus();
+        }
+
+        /// @brief Starts the normalization of a hand, see Feel::StartNormalization()
+        void StartNormalization(std::size_t hand)
+        {
+            hands[hand]->state.StartNormalization();
+        }
+
+        /// @brief Set the normalization data of a hand, see Feel::SetCalibrationData()
+        void SetCalibrationData(std::size_t hand, const CalibrationData& data)
+        {
+            hands[hand]->state.SetCalibrationData(data);
+        }
+
+        /// @brief Get the normalization data of a hand
+        CalibrationData GetCalibrationData(std::size_t hand) const
+        {
+            return hands[hand]->state.GetCalibrationData();
+        }
+
+        /// @brief Check the calibration data of a hand against the glove, see Feel::CheckCalibration()
+        CalibrationCheck CheckCalibration(std::size_t hand, std::uint32_t minimumSamples = 5, float tolerance = 0.1f) const
+        {
+            return hands[hand]->state.CheckCalibration(minimumSamples, tolerance);
+        }
+
+        /// @brief Starts the session of a hand, see Feel::BeginSession()
+        void BeginSession(std::size_t hand)
+        {
+            hands[hand]->state.BeginSession();
+        }
+
+        /// @brief Ends the session of a hand
+        void EndSession(std::size_t hand)
+        {
+            hands[hand]->state.EndSession();
+        }
+
+        /// @brief Move a finger to a specific angle, see Feel::SetFingerAngle()
+        void SetFingerAngle(std::size_t hand, Finger finger, float angle, int force)
+        {
+            CommandBuffer command;
+            if (hands[hand]->encoder.EncodeFingerAngle(finger, angle, force, command))
+            {
+                hands[hand]->device->TransmitMessage(command);
+            }
+        }
+
+        /// @brief Release the force from a finger, see Feel::ReleaseFinger()
+        void ReleaseFinger(std::size_t hand, Finger finger)
+        {
+            CommandBuffer command;
+            if (hands[hand]->encoder.EncodeReleaseFinger(finger, command))
+            {
+                hands[hand]->device->TransmitMessage(command);
+            }
+        }
+
+        /// @brief Move or release several fingers of a hand at once, see Feel::SetFingerTargets()
+        void SetFingerTargets(std::size_t hand, const FingerTarget* targets, std::size_t count)
+        {
+            hands[hand]->encoder.TransmitTargets(*hands[hand]->device, targets, count);
+        }
+
+        /// @brief Get the filtered angle of a finger, ranges from 0 - 180
+        float GetFingerAngle(std::size_t hand, Finger finger) const
+        {
+            return filters.Filters().Output(Channel(hand, finger));
+        }
+
+        /// @brief Get the filtered angles of all fingers of all hands
+        /// @return ChannelCount() angles, indexed by Channel()
+        const float* GetFingerAngles() const
+        {
+            return filters.Filters().Outputs();
+        }
+
+        /// @brief Get the latest unfiltered sample of a finger, see Feel::GetLatestFingerSample()
+        FingerSample GetLatestFingerSample(std::size_t hand, Finger finger) const
+        {
+            const FingerHistory& history = GetFingerHistory(hand, finger);
+            return history.Empty() ? FingerSample{} : history.Latest();
+        }
+
+        /// @brief Get how fast a finger is moving in degrees per second
+        float GetFingerVelocity(std::size_t hand, Finger finger) const
+        {
+            return GetFingerHistory(hand, finger).Velocity();
+        }
+
+        /// @brief Get how fast the velocity of a finger is changing in degrees per second squared
+        float GetFingerAcceleration(std::size_t hand, Finger finger) const
+        {
+            return GetFingerHistory(hand, finger).Acceleration();
+        }
+
+        /// @brief Get the recent samples of a finger, valid until the next ParseMessages()
+        const FingerHistory& GetFingerHistory(std::size_t hand, Finger finger) const
+        {
+            return hands[hand]->state.GetFingerHistory(static_cast<int>(finger));
+        }
+
+        /// @brief Set how the samples of a finger are filtered, see Feel::SetFingerFilter()
+        void SetFingerFilter(std::size_t hand, Finger finger, const FilterSettings& settings)
+        {
+            filters.Filters().Configure(Channel(hand, finger), settings);
+        }
+
+        /// @brief Set how the samples of all fingers of all hands are filtered
+        void SetFilter(const FilterSettings& settings)
+        {
+            for (std::size_t i = 0; i < ChannelCount(); i++)
+            {
+                filters.Filters().Configure(i, settings);
+            }
+        }
+
+        /// @brief Set which function should be called when a Debug message from a device is processed
+        /// @param callback Gets the index of the hand and the message.
+        /// By default the messages go to Logger::Default(), pass an empty function to restore that.
+        void SetDebugLogCallback(std::function<void(std::size_t, std::string)> callback)
+        {
+            debugLogCallback = callback;
+        }
+
+        /// @brief Set the function to call for messages with the given identifier, see Feel::RegisterMessageHandler()
+        /// @param handler Gets the index of the hand and the whole message
+        /// @return false if the identifier is invalid or belongs to a built-in message
+        bool RegisterMessageHandler(const char* identifier, std::function<void(std::size_t, const ReceivedMessage&)> handler)
+        {
+            if (!GloveState::IsCustomIdentifier(identifier)) return false;
+            for (auto& hand : hands)
+            {
+                RegisterHandHandler(hand->state, hand->index, identifier, handler);
+            }
+            // Kept for the hands added later
+            for (auto& registered : messageHandlers)
+            {
+                if (registered.first == identifier)
+                {
+                    registered.second = handler;
+                    return true;
+                }
+            }
+            messageHandlers.emplace_back(identifier, handler);
+            return true;
+        }
+
+        /// @brief The number of received messages with an identifier nothing handles, of all hands
+        std::uint64_t GetUnknownMessageCount() const
+        {
+            std::uint64_t count = 0;
+            for (auto& hand : hands)
+            {
+                count += hand->state.GetUnknownMessageCount();
+            }
+            return count;
+        }
+
+        /// @brief The number of malformed messages that were dropped, of all hands
+        RejectedFrameCounts GetRejectedFrameCounts() const
+        {
+            RejectedFrameCounts counts;
+            for (auto& hand : hands)
+            {
+                RejectedFrameCounts handCounts = hand->state.GetRejectedFrameCounts();
+                counts.truncated += handCounts.truncated;
+                counts.invalidNumber += handCounts.invalidNumber;
+                counts.fingerOutOfRange += handCounts.fingerOutOfRange;
+            }
+            return counts;
+        }
+
+        /// @brief Measure the latencies of a hand, see Feel::SetInstrumentation()
+        void SetInstrumentation(std::size_t hand, bool enabled)
+        {
+            hands[hand]->state.SetInstrumentation(enabled);
+        }
+
+        /// @brief Send a probe the device of a hand echoes back, see Feel::SendLatencyProbe()
+        std::uint16_t SendLatencyProbe(std::size_t hand)
+        {
+            return hands[hand]->state.SendLatencyProbe();
+        }
+
+        /// @brief Get the latencies of a hand measured so far
+        LatencyHistogramData GetLatencyHistogram(std::size_t hand, LatencyStage stage) const
+        {
+            return hands[hand]->state.GetLatencyHistogram(stage);
+        }
+
+        /// @brief Processes the incoming messages of all hands since the last call
+        ///
+        /// This function should typically be called once per frame.
+        void ParseMessages()
+        {
+            std::uint64_t ready = readyHands.exchange(0, std::memory_order_acquire) | polledHands;
+            for (std::size_t hand = 0; ready != 0; hand++, ready >>= 1)
+            {
+                if ((ready & 1) == 0) continue;
+                hands[hand]->state.ParseMessages(inputBatch);
+            }
+            filters.Process();
+        }
+
+    private:
+        struct Hand
+        {
+            Hand(Device* device, FingerFilterBatch& filters, std::size_t index) :
+                device(device),
+                index(index),
+                state(device, filters, index * FINGER_TYPE_COUNT)
+            {}
+
+            Device* device;
+            std::size_t index;
+            GloveState state;
+            FingerCommandEncoder encoder;
+        };
+
+        // Heap allocated, the devices' listeners must not see them move
+        std::vector<std::unique_ptr<Hand>> hands;
+
+        // The state table, one channel per finger of every hand
+        FingerFilterBatch filters;
+
+        // One bit per hand, set by the devices' receiving threads
+        std::atomic<std::uint64_t> readyHands;
+        // Hands whose device cannot notify
+        std::uint64_t polledHands;
+        // Reused for every hand
+        MessageBatch inputBatch;
+        // Set for every hand, including the ones added later
+        std::vector<std::pair<std::string, std::function<void(std::size_t, const ReceivedMessage&)>>> messageHandlers;
+
+        std::function<void(std::size_t, std::string)> debugLogCallback;
+
+        static void RegisterHandHandler(GloveState& state, std::size_t index, const char* identifier, const std::function<void(std::size_t, const ReceivedMessage&)>& handler)
+        {
+            if (!handler)
+            {
+                state.RegisterMessageHandler(identifier, nullptr);
+                return;
+            }
+            state.RegisterMessageHandler(identifier, [handler, index](const ReceivedMessage& received)
+            {
+                handler(index, received);
+            });
+        }
+    };
+}
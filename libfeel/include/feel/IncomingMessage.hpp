@@ -7,6 +7,10 @@ namespace feel
         FingerUpdate,
         DebugLog,
         NormalizationData,
-        EndNormalization
+        EndNormalization,
+        ProbeEcho,
+        NormalizationBulk,
+        /// @brief Not one of the built-in messages, may have a registered handler
+        Unknown
     };
 }
\ No newline at end of file
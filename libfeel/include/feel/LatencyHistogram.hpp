@@ -0,0 +1,134 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace feel
+{
+    /// @brief The latencies measured by SetInstrumentation()
+    enum class LatencyStage
+    {
+        /// @brief From handing a message to the device until it is written to the port
+        Send,
+        /// @brief From receiving a finger update until GetFingerAngle() returns it
+        Consume,
+        /// @brief From sending a latency probe until its echo was received
+        RoundTrip
+    };
+
+    /// @brief The counts of a LatencyHistogram at one point in time
+    ///
+    /// Bucket 0 counts latencies below 1 microsecond, bucket i counts
+    /// latencies from 2^(i-1) up to 2^i microseconds. The last bucket
+    /// also counts everything above.
+    struct LatencyHistogramData
+    {
+        static constexpr std::size_t BUCKET_COUNT = 32;
+
+        std::array<std::uint64_t, BUCKET_COUNT> buckets = {};
+        std::uint64_t count = 0;
+        std::uint64_t totalMicroseconds = 0;
+        std::uint64_t maxMicroseconds = 0;
+
+        /// @brief The exclusive upper limit of a bucket in microseconds
+        static std::uint64_t BucketLimit(std::size_t bucket)
+        {
+            return std::uint64_t(1) << bucket;
+        }
+
+        double MeanMicroseconds() const
+        {
+            return count == 0 ? 0 : double(totalMicroseconds) / count;
+        }
+
+        /// @brief Estimate a percentile from the buckets
+        /// @param percentile 0 - 100
+        /// @return The upper limit of the bucket the percentile falls into, at most maxMicroseconds
+        std::uint64_t PercentileMicroseconds(double percentile) const
+        {
+            if (count == 0) return 0;
+            double rank = percentile / 100 * count;
+            std::uint64_t seen = 0;
+            for (std::size_t i = 0; i < BUCKET_COUNT; i++)
+            {
+                seen += buckets[i];
+                if (seen >= rank && seen > 0)
+                {
+                    std::uint64_t limit = BucketLimit(i);
+                    return limit < maxMicroseconds ? limit : maxMicroseconds;
+                }
+            }
+            return maxMicroseconds;
+        }
+    };
+
+    /// @brief Counts latencies in power of two microsecond buckets
+    ///
+    /// Recording is wait-free and never allocates, so it can be
+    /// done on the I/O threads. Data() may be called from any thread.
+    class LatencyHistogram
+    {
+    public:
+        LatencyHistogram()
+        {
+            Reset();
+        }
+
+        LatencyHistogram(const LatencyHistogram&) = delete;
+        LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+        void Record(std::chrono::steady_clock::duration latency)
+        {
+            auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+            std::uint64_t value = microseconds < 0 ? 0 : static_cast<std::uint64_t>(microseconds);
+            buckets[BucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+            count.fetch_add(1, std::memory_order_relaxed);
+            total.fetch_add(value, std::memory_order_relaxed);
+            std::uint64_t previous = max.load(std::memory_order_relaxed);
+            while (previous < value && !max.compare_exchange_weak(previous, value, std::memory_order_relaxed)) {}
+        }
+
+        LatencyHistogramData Data() const
+        {
+            LatencyHistogramData data;
+            for (std::size_t i = 0; i < LatencyHistogramData::BUCKET_COUNT; i++)
+            {
+                data.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+            }
+            data.count = count.load(std::memory_order_relaxed);
+            data.totalMicroseconds = total.load(std::memory_order_relaxed);
+            data.maxMicroseconds = max.load(std::memory_order_relaxed);
+            return data;
+        }
+
+        void Reset()
+        {
+            for (auto& bucket : buckets)
+            {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            count.store(0, std::memory_order_relaxed);
+            total.store(0, std::memory_order_relaxed);
+            max.store(0, std::memory_order_relaxed);
+        }
+
+    private:
+        std::array<std::atomic<std::uint64_t>, LatencyHistogramData::BUCKET_COUNT> buckets;
+        std::atomic<std::uint64_t> count;
+        std::atomic<std::uint64_t> total;
+        std::atomic<std::uint64_t> max;
+
+        static std::size_t BucketOf(std::uint64_t microseconds)
+        {
+            std::size_t bucket = 0;
+            while (microseconds != 0 && bucket + 1 < LatencyHistogramData::BUCKET_COUNT)
+            {
+                microseconds >>= 1;
+                bucket++;
+            }
+            return bucket;
+        }
+    };
+}
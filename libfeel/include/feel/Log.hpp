@@ -0,0 +1,286 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace feel
+{
+    enum class LogLevel
+    {
+        Trace,
+        Debug,
+        Info,
+        Warning,
+        Error,
+        /// @brief Disables logging when passed to Logger::SetLevel()
+        Off
+    };
+
+    /// @brief Leveled logging with the output done on a background thread
+    ///
+    /// Log lines are copied (or formatted) into preallocated slots of a bounded
+    /// lock-free queue, any thread may log. A background thread hands them to
+    /// the sink, by default the console. Logging never waits for the sink and
+    /// never allocates, lines that do not fit into the queue are dropped and
+    /// counted, longer lines are cut at LINE_SIZE.
+    ///
+    /// Checking the level is a single relaxed load, so disabled levels cost
+    /// nothing and Format() does not format them at all.
+    class Logger
+    {
+    public:
+        static constexpr std::size_t CAPACITY = 1024;
+        static constexpr std::size_t LINE_SIZE = 224;
+
+        using Sink = std::function<void(LogLevel, const char*, std::size_t)>;
+
+        /// @brief The logger used by the library
+        static Logger& Default()
+        {
+            static Logger logger;
+            return logger;
+        }
+
+        Logger() :
+            level(LogLevel::Debug),
+            enqueuePosition(0),
+            dequeuePosition(0),
+            written(0),
+            dropped(0),
+            running(true),
+            sinkWaiting(false)
+        {
+            for (std::size_t i = 0; i < CAPACITY; i++)
+            {
+                records[i].sequence.store(i, std::memory_order_relaxed);
+            }
+            worker = std::thread(&Logger::SinkThread, this);
+        }
+
+        Logger(const Logger&) = delete;
+        Logger& operator=(const Logger&) = delete;
+
+        /// @brief Writes out what is queued and stops the background thread
+        ~Logger()
+        {
+            running = false;
+            wake.notify_one();
+            worker.join();
+        }
+
+        /// @brief Lines below the level are discarded, LogLevel::Off discards everything
+        void SetLevel(LogLevel newLevel)
+        {
+            level.store(newLevel, std::memory_order_relaxed);
+        }
+
+        LogLevel GetLevel() const
+        {
+            return level.load(std::memory_order_relaxed);
+        }
+
+        bool IsEnabled(LogLevel lineLevel) const
+        {
+            return lineLevel != LogLevel::Off && lineLevel >= level.load(std::memory_order_relaxed);
+        }
+
+        /// @brief Set the function that outputs the lines, an empty function restores the console
+        ///
+        /// It is called on the background thread, the text is not null terminated.
+        void SetSink(Sink newSink)
+        {
+            std::lock_guard<std::mutex> lock(sinkMutex);
+            sink = newSink;
+        }
+
+        void Write(LogLevel lineLevel, const char* text, std::size_t length)
+        {
+            if (!IsEnabled(lineLevel)) return;
+            std::size_t position;
+            Record* record = Claim(position);
+            if (record == nullptr) return;
+            record->length = Truncate(length);
+            std::memcpy(record->text.data(), text, record->length);
+            Publish(record, lineLevel, position);
+        }
+
+        void Write(LogLevel lineLevel, const char* text)
+        {
+            Write(lineLevel, text, std::strlen(text));
+        }
+
+        void Write(LogLevel lineLevel, const std::string& text)
+        {
+            Write(lineLevel, text.data(), text.size());
+        }
+
+        /// @brief Log a printf style formatted line
+        ///
+        /// The line is formatted straight into the queue, and only if the level is enabled.
+        template<typename... Args>
+        void Format(LogLevel lineLevel, const char* format, Args... args)
+        {
+            if (!IsEnabled(lineLevel)) return;
+            std::size_t position;
+            Record* record = Claim(position);
+            if (record == nullptr) return;
+            int length = std::snprintf(record->text.data(), LINE_SIZE + 1, format, args...);
+            record->length = length < 0 ? 0 : Truncate(static_cast<std::size_t>(length));
+            Publish(record, lineLevel, position);
+        }
+
+        /// @brief Wait until every line logged so far reached the sink
+        void Flush()
+        {
+            std::size_t target = enqueuePosition.load(std::memory_order_acquire);
+            while (written.load(std::memory_order_acquire) < target)
+            {
+                wake.notify_one();
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+
+        /// @brief How many lines were dropped because the queue was full
+        std::uint64_t DroppedCount() const
+        {
+            return dropped.load(std::memory_order_relaxed);
+        }
+
+        static const char* LevelName(LogLevel lineLevel)
+        {
+            switch (lineLevel)
+            {
+                case LogLevel::Trace: return "trace";
+                case LogLevel::Debug: return "debug";
+                case LogLevel::Info: return "info";
+                case LogLevel::Warning: return "warning";
+                case LogLevel::Error: return "error";
+                default: return "";
+            }
+        }
+
+    private:
+        // A slot is free for position p when sequence == p,
+        // and holds the line of position p when sequence == p + 1.
+        struct Record
+        {
+            std::atomic<std::size_t> sequence;
+            LogLevel level;
+            std::size_t length;
+            // One more for the terminator snprintf writes
+            std::array<char, LINE_SIZE + 1> text;
+        };
+
+        static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+        std::atomic<LogLevel> level;
+        std::array<Record, CAPACITY> records;
+        std::atomic<std::size_t> enqueuePosition;
+        // Only used by the background thread
+        std::size_t dequeuePosition;
+        std::atomic<std::size_t> written;
+        std::atomic<std::uint64_t> dropped;
+
+        std::atomic<bool> running;
+        std::atomic<bool> sinkWaiting;
+        std::mutex wakeMutex;
+        std::condition_variable wake;
+        std::mutex sinkMutex;
+        Sink sink;
+        std::thread worker;
+
+        Record* Claim(std::size_t& position)
+        {
+            position = enqueuePosition.load(std::memory_order_relaxed);
+            while (true)
+            {
+                Record& record = records[position & (CAPACITY - 1)];
+                std::size_t sequence = record.sequence.load(std::memory_order_acquire);
+                if (sequence == position)
+                {
+                    if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) return &record;
+                }
+                else if (sequence < position + 1)
+                {
+                    // The slot still holds a line of the previous round, the queue is full
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+                else
+                {
+                    position = enqueuePosition.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void Publish(Record* record, LogLevel lineLevel, std::size_t position)
+        {
+            record->level = lineLevel;
+            record->sequence.store(position + 1, std::memory_order_release);
+            // Without the mutex a wakeup can be missed, the thread then wakes up on its own
+            if (sinkWaiting.load(std::memory_order_relaxed))
+            {
+                wake.notify_one();
+            }
+        }
+
+        static std::size_t Truncate(std::size_t length)
+        {
+            return length < LINE_SIZE ? length : std::size_t(LINE_SIZE);
+        }
+
+        void SinkThread()
+        {
+            // How long to sleep when a wakeup may have been missed
+            const std::chrono::milliseconds idleWait(10);
+            while (true)
+            {
+                bool stopping = !running;
+                if (Drain() > 0) continue;
+                if (stopping) return;
+                std::unique_lock<std::mutex> lock(wakeMutex);
+                sinkWaiting = true;
+                wake.wait_for(lock, idleWait);
+                sinkWaiting = false;
+            }
+        }
+
+        std::size_t Drain()
+        {
+            std::lock_guard<std::mutex> lock(sinkMutex);
+            std::size_t count = 0;
+            while (true)
+            {
+                Record& record = records[dequeuePosition & (CAPACITY - 1)];
+                if (record.sequence.load(std::memory_order_acquire) != dequeuePosition + 1) break;
+                if (sink)
+                {
+                    sink(record.level, record.text.data(), record.length);
+                }
+                else
+                {
+                    std::cout << '[' << LevelName(record.level) << "] ";
+                    std::cout.write(record.text.data(), record.length);
+                    std::cout << '\n';
+                }
+                record.sequence.store(dequeuePosition + CAPACITY, std::memory_order_release);
+                dequeuePosition++;
+                written.store(dequeuePosition, std::memory_order_release);
+                count++;
+            }
+            // One flush per batch instead of one per line
+            if (count > 0 && !sink) std::cout.flush();
+            return count;
+        }
+    };
+}
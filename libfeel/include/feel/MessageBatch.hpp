@@ -0,0 +1,110 @@
+#pragma once
+#include "feel/ReceivedMessage.hpp"
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+namespace feel
+{
+    /// @brief The messages taken out of a device at once by Device::DrainMessages()
+    ///
+    /// Messages are either copied into an arena owned by the batch or refer to
+    /// memory the device keeps alive until it is drained again. The arena and
+    /// the list of messages keep their capacity when the batch is cleared,
+    /// so draining into the same batch every frame stops allocating after
+    /// the first few frames.
+    class MessageBatch
+    {
+    public:
+        using const_iterator = std::vector<ReceivedMessage>::const_iterator;
+
+        /// @brief Remove all messages, the memory is kept for reuse
+        void Clear()
+        {
+            arena.clear();
+            messages.clear();
+            copied.clear();
+        }
+
+        /// @brief Reserve room for count messages with a total of bytes characters
+        void Reserve(std::size_t count, std::size_t bytes)
+        {
+            if (arena.capacity() < bytes) Grow(bytes);
+            messages.reserve(count);
+            copied.reserve(count);
+        }
+
+        /// @brief Add a message that is copied into the arena
+        void Append(const char* data, std::size_t length, std::chrono::steady_clock::time_point timestamp)
+        {
+            char* target = Allocate(length, timestamp);
+            if (length > 0) std::memcpy(target, data, length);
+        }
+
+        /// @brief Add a message stored in the arena and return where to write its data
+        ///
+        /// The pointer is only valid until the next message is added.
+        char* Allocate(std::size_t length, std::chrono::steady_clock::time_point timestamp)
+        {
+            std::size_t offset = arena.size();
+            if (arena.capacity() < offset + length) Grow(2 * (offset + length));
+            arena.resize(offset + length);
+            copied.push_back(Copied{ messages.size(), offset });
+            messages.push_back(ReceivedMessage{ arena.data() + offset, length, timestamp });
+            return arena.data() + offset;
+        }
+
+        /// @brief Add a message without copying it, its data must outlive the batch contents
+        void AppendView(const ReceivedMessage& message)
+        {
+            messages.push_back(message);
+        }
+
+        std::size_t Size() const
+        {
+            return messages.size();
+        }
+
+        bool Empty() const
+        {
+            return messages.empty();
+        }
+
+        const ReceivedMessage& operator[](std::size_t index) const
+        {
+            return messages[index];
+        }
+
+        const_iterator begin() const
+        {
+            return messages.begin();
+        }
+
+        const_iterator end() const
+        {
+            return messages.end();
+        }
+
+    private:
+        struct Copied
+        {
+            std::size_t index;
+            std::size_t offset;
+        };
+
+        std::vector<char> arena;
+        std::vector<ReceivedMessage> messages;
+        // The messages stored in the arena, they move when it grows
+        std::vector<Copied> copied;
+
+        void Grow(std::size_t capacity)
+        {
+            arena.reserve(capacity);
+            for (const Copied& message : copied)
+            {
+                messages[message.index].data = arena.data() + message.offset;
+            }
+        }
+    };
+}
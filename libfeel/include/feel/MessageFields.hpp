@@ -0,0 +1,188 @@
+#pragma once
+#include "feel/Finger.hpp"
+#include "feel/ReceivedMessage.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace feel
+{
+    /// @brief Why a received message was rejected
+    enum class FrameError
+    {
+        None,
+        /// @brief The message ends before all of its fields
+        Truncated,
+        /// @brief A field has a character that is not a digit, or too many digits
+        InvalidNumber,
+        /// @brief The finger index is not below FINGER_TYPE_COUNT
+        FingerOutOfRange
+    };
+
+    /// @brief The number of rejected messages by reason
+    struct RejectedFrameCounts
+    {
+        std::uint64_t truncated = 0;
+        std::uint64_t invalidNumber = 0;
+        std::uint64_t fingerOutOfRange = 0;
+
+        void Count(FrameError error)
+        {
+            switch (error)
+            {
+                case FrameError::Truncated: truncated++; break;
+                case FrameError::InvalidNumber: invalidNumber++; break;
+                case FrameError::FingerOutOfRange: fingerOutOfRange++; break;
+                default: break;
+            }
+        }
+
+        std::uint64_t Total() const
+        {
+            return truncated + invalidNumber + fingerOutOfRange;
+        }
+    };
+
+    /// @brief Reads the numeric fields of a message one after another
+    ///
+    /// Works on the received bytes directly, it neither allocates nor throws.
+    /// The first error is kept, every later read returns 0, so a message can
+    /// be read completely and checked once with Error():
+    ///
+    ///     MessageFields fields(received);
+    ///     int finger = fields.Finger();
+    ///     int angle = fields.Decimal();
+    ///     if (fields.Error() != FrameError::None) ...
+    class MessageFields
+    {
+    public:
+        /// @brief The longest variable width number, so the value always fits into an int
+        static constexpr std::size_t MAX_DIGITS = 7;
+
+        /// @brief Start reading after the identifier
+        explicit MessageFields(const ReceivedMessage& message) :
+            MessageFields(message.data, message.length)
+        {}
+
+        MessageFields(const char* data, std::size_t length, std::size_t position = 2) :
+            data(data),
+            length(length),
+            position(position),
+            error(length < position ? FrameError::Truncated : FrameError::None)
+        {}
+
+        /// @brief Read width hex digits
+        int Hex(std::size_t width)
+        {
+            return Read(width, 16);
+        }
+
+        /// @brief Read width decimal digits
+        int Decimal(std::size_t width)
+        {
+            return Read(width, 10);
+        }
+
+        /// @brief Read the rest of the message as a hex number of 1 to MAX_DIGITS digits
+        int Hex()
+        {
+            return ReadRest(16);
+        }
+
+        /// @brief Read the rest of the message as a decimal number of 1 to MAX_DIGITS digits and an optional '-'
+        int Decimal()
+        {
+            bool negative = position < length && data[position] == '-';
+            if (negative && error == FrameError::None) position++;
+            int value = ReadRest(10);
+            return negative ? -value : value;
+        }
+
+        /// @brief Read a finger index, 2 hex digits below FINGER_TYPE_COUNT
+        int Finger()
+        {
+            int finger = Hex(2);
+            if (finger >= FINGER_TYPE_COUNT) Fail(FrameError::FingerOutOfRange);
+            return error == FrameError::None ? finger : 0;
+        }
+
+        /// @brief Where the next field starts
+        std::size_t Position() const
+        {
+            return position;
+        }
+
+        FrameError Error() const
+        {
+            return error;
+        }
+
+        /// @brief The value of a single digit, -1 if c is not a digit of the base
+        static int Digit(char c, int base)
+        {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (base == 16 && c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (base == 16 && c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        /// @brief Parse width digits at text
+        /// @return -1 if a character is not a digit of the base
+        static int Parse(const char* text, std::size_t width, int base)
+        {
+            int value = 0;
+            for (std::size_t i = 0; i < width; i++)
+            {
+                int digit = Digit(text[i], base);
+                if (digit < 0) return -1;
+                value = value * base + digit;
+            }
+            return value;
+        }
+
+    private:
+        const char* data;
+        std::size_t length;
+        std::size_t position;
+        FrameError error;
+
+        void Fail(FrameError reason)
+        {
+            if (error == FrameError::None) error = reason;
+        }
+
+        int Read(std::size_t width, int base)
+        {
+            if (error != FrameError::None) return 0;
+            if (length - position < width)
+            {
+                Fail(FrameError::Truncated);
+                return 0;
+            }
+            int value = Parse(data + position, width, base);
+            if (value < 0)
+            {
+                Fail(FrameError::InvalidNumber);
+                return 0;
+            }
+            position += width;
+            return value;
+        }
+
+        int ReadRest(int base)
+        {
+            if (error != FrameError::None) return 0;
+            std::size_t width = length - position;
+            if (width == 0)
+            {
+                Fail(FrameError::Truncated);
+                return 0;
+            }
+            if (width > MAX_DIGITS)
+            {
+                Fail(FrameError::InvalidNumber);
+                return 0;
+            }
+            return Read(width, base);
+        }
+    };
+}
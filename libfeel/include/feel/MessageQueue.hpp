@@ -0,0 +1,165 @@
+#pragma once
+#include "feel/RingBuffer.hpp"
+#include "feel/ReceivedMessage.hpp"
+#include "feel/MessageBatch.hpp"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace feel
+{
+    /// @brief A fixed-size piece of an incoming message.
+    ///
+    /// Short messages (like "UF") fit into a single slot,
+    /// longer ones are spread over consecutive slots.
+    struct MessageSlot
+    {
+        static constexpr std::size_t DATA_SIZE = 22;
+
+        std::chrono::steady_clock::time_point timestamp;
+        std::uint16_t length;
+        std::array<char, DATA_SIZE> data;
+    };
+
+    /// @brief Single-producer/single-consumer queue of incoming messages
+    ///
+    /// Messages are copied into preallocated slots, so handing them
+    /// from the receiving thread to the parsing thread never allocates.
+    class MessageQueue
+    {
+    public:
+        static constexpr std::size_t CAPACITY = 4096;
+        static constexpr std::size_t MAX_MESSAGE_SIZE = 0xffff;
+
+        /// @brief Producer: append a message
+        /// @param timestamp When the message was received
+        /// @return false if the queue is full, the message is dropped
+        bool TryPush(const char* message, std::size_t length, std::chrono::steady_clock::time_point timestamp)
+        {
+            if (length > MAX_MESSAGE_SIZE) length = MAX_MESSAGE_SIZE;
+            std::size_t slotCount = SlotCount(length);
+            if (slotCount > slots.Free())
+            {
+                overflows.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            // Long messages are published in several steps,
+            // Drain() only consumes them once they are complete.
+            std::size_t pushed = 0;
+            while (pushed < slotCount)
+            {
+                std::size_t batch = slotCount - pushed < staging.size() ? slotCount - pushed : staging.size();
+                for (std::size_t i = 0; i < batch; i++)
+                {
+                    FillSlot(staging[i], message, length, pushed + i);
+                    staging[i].timestamp = timestamp;
+                }
+                slots.TryPush(staging.data(), batch);
+                pushed += batch;
+            }
+            return true;
+        }
+
+        /// @brief Consumer: call callback(const ReceivedMessage&) for every queued message
+        template<typename Callback>
+        void Drain(Callback&& callback)
+        {
+            std::size_t available = slots.Available();
+            std::size_t consumed = 0;
+            while (consumed < available)
+            {
+                const MessageSlot& first = slots.Peek(consumed);
+                std::size_t length = first.length;
+                std::size_t slotCount = SlotCount(length);
+                if (consumed + slotCount > available) break;
+                if (slotCount == 1)
+                {
+                    callback(ReceivedMessage{ first.data.data(), length, first.timestamp });
+                }
+                else
+                {
+                    scratch.clear();
+                    for (std::size_t i = 0; i < slotCount; i++)
+                    {
+                        std::size_t offset = i * MessageSlot::DATA_SIZE;
+                        std::size_t chunk = length - offset < MessageSlot::DATA_SIZE ? length - offset : MessageSlot::DATA_SIZE;
+                        scratch.append(slots.Peek(consumed + i).data.data(), chunk);
+                    }
+                    callback(ReceivedMessage{ scratch.data(), length, first.timestamp });
+                }
+                consumed += slotCount;
+            }
+            slots.Pop(consumed);
+        }
+
+        /// @brief Consumer: append every queued message to batch
+        ///
+        /// All messages are copied before any slot is released,
+        /// so the producer sees a single pop for the whole batch.
+        /// @return The number of messages appended
+        std::size_t DrainInto(MessageBatch& batch)
+        {
+            std::size_t available = slots.Available();
+            batch.Reserve(batch.Size() + available, available * MessageSlot::DATA_SIZE);
+            std::size_t consumed = 0;
+            std::size_t count = 0;
+            while (consumed < available)
+            {
+                const MessageSlot& first = slots.Peek(consumed);
+                std::size_t length = first.length;
+                std::size_t slotCount = SlotCount(length);
+                if (consumed + slotCount > available) break;
+                char* target = batch.Allocate(length, first.timestamp);
+                for (std::size_t i = 0; i < slotCount; i++)
+                {
+                    std::size_t offset = i * MessageSlot::DATA_SIZE;
+                    std::size_t chunk = length - offset < MessageSlot::DATA_SIZE ? length - offset : MessageSlot::DATA_SIZE;
+                    std::memcpy(target + offset, slots.Peek(consumed + i).data.data(), chunk);
+                }
+                consumed += slotCount;
+                count++;
+            }
+            slots.Pop(consumed);
+            return count;
+        }
+
+        bool Empty() const
+        {
+            return slots.Empty();
+        }
+
+        /// @brief Producer: the number of free slots, a message takes one slot per MessageSlot::DATA_SIZE bytes
+        std::size_t Free() const
+        {
+            return slots.Free();
+        }
+
+        /// @brief How many messages were dropped because the queue was full
+        std::uint64_t OverflowCount() const
+        {
+            return overflows.load(std::memory_order_relaxed);
+        }
+
+    private:
+        RingBuffer<MessageSlot, CAPACITY> slots;
+        std::atomic<std::uint64_t> overflows{ 0 };
+        std::array<MessageSlot, 8> staging;
+        std::string scratch;
+
+        static std::size_t SlotCount(std::size_t length)
+        {
+            return length == 0 ? 1 : (length + MessageSlot::DATA_SIZE - 1) / MessageSlot::DATA_SIZE;
+        }
+
+        static void FillSlot(MessageSlot& slot, const char* message, std::size_t length, std::size_t index)
+        {
+            std::size_t offset = index * MessageSlot::DATA_SIZE;
+            std::size_t chunk = length - offset < MessageSlot::DATA_SIZE ? length - offset : MessageSlot::DATA_SIZE;
+            slot.length = static_cast<std::uint16_t>(length);
+            std::memcpy(slot.data.data(), message + offset, chunk);
+        }
+    };
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "feel/IncomingMessage.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace feel
+{
+    /// @brief Maps the two character identifiers of incoming messages to their type
+    ///
+    /// Identifiers are made of 'A' - 'Z' and '0' - '9'. Every possible one has a
+    /// slot in a table built at compile time, so a lookup is a single load and
+    /// unknown identifiers never change the table.
+    class MessageTypeTable
+    {
+    public:
+        static constexpr std::size_t SYMBOL_COUNT = 36;
+        static constexpr std::size_t SIZE = SYMBOL_COUNT * SYMBOL_COUNT;
+        /// @brief The index of identifiers with other characters
+        static constexpr std::size_t INVALID_INDEX = SIZE;
+
+        /// @brief The slot of an identifier, INVALID_INDEX if it has other characters
+        static constexpr std::size_t Index(char first, char second)
+        {
+            return Symbol(first) == SYMBOL_COUNT || Symbol(second) == SYMBOL_COUNT
+                ? INVALID_INDEX
+                : Symbol(first) * SYMBOL_COUNT + Symbol(second);
+        }
+
+        /// @brief The built-in type of the identifier at index
+        static IncomingMessage Lookup(std::size_t index)
+        {
+            return index < SIZE ? static_cast<IncomingMessage>(Table().types[index]) : IncomingMessage::Unknown;
+        }
+
+    private:
+        struct Types
+        {
+            std::uint8_t types[SIZE];
+        };
+
+        static constexpr std::size_t Symbol(char c)
+        {
+            return c >= 'A' && c <= 'Z' ? static_cast<std::size_t>(c - 'A')
+                : c >= '0' && c <= '9' ? static_cast<std::size_t>(26 + c - '0')
+                : SYMBOL_COUNT;
+        }
+
+        static constexpr Types Build()
+        {
+            Types table{};
+            for (std::size_t i = 0; i < SIZE; i++)
+            {
+                table.types[i] = IncomingMessage::Unknown;
+            }
+            table.types[Index('U', 'F')] = IncomingMessage::FingerUpdate;
+            table.types[Index('D', 'L')] = IncomingMessage::DebugLog;
+            table.types[Index('N', 'I')] = IncomingMessage::NormalizationData;
+            table.types[Index('N', 'B')] = IncomingMessage::NormalizationBulk;
+            table.types[Index('E', 'N')] = IncomingMessage::EndNormalization;
+            table.types[Index('P', 'O')] = IncomingMessage::ProbeEcho;
+            return table;
+        }
+
+        static const Types& Table()
+        {
+            static constexpr Types table = Build();
+            return table;
+        }
+    };
+}
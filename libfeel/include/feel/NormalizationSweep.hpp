@@ -0,0 +1,85 @@
+#pragma once
+#include "feel/MessageFields.hpp"
+#include <cstddef>
+
+namespace feel
+{
+    /// @brief A whole normalization sweep of one finger, sent as a single "NB" message
+    ///
+    /// Replaces one "NI" message per angle. After the identifier follow
+    /// the finger (2 hex digits), the real angle of the first sample (3 decimal digits),
+    /// the sample count (2 hex digits) and every sample (3 hex digits each).
+    /// The real angle of sample i is firstRealAngle + i.
+    /// Decoding only looks at the message, it neither copies nor allocates.
+    /// The finger is checked against FINGER_TYPE_COUNT.
+    struct NormalizationSweep
+    {
+        static constexpr std::size_t HEADER_SIZE = 2 + 2 + 3 + 2;
+        static constexpr std::size_t SAMPLE_WIDTH = 3;
+        static constexpr std::size_t MAX_SAMPLES = 0xff;
+        static constexpr int MAX_ANGLE = 0xfff;
+
+        int finger = 0;
+        int firstRealAngle = 0;
+        std::size_t count = 0;
+        const char* samples = nullptr;
+
+        /// @brief The raw device angle of sample i
+        int Angle(std::size_t i) const
+        {
+            return MessageFields::Parse(samples + i * SAMPLE_WIDTH, SAMPLE_WIDTH, 16);
+        }
+
+        /// @brief Read a sweep from a received message, including the identifier
+        /// @return FrameError::None on success, sweep is unchanged otherwise
+        static FrameError Decode(const char* message, std::size_t length, NormalizationSweep& sweep)
+        {
+            MessageFields fields(message, length);
+            int finger = fields.Finger();
+            int firstRealAngle = fields.Decimal(3);
+            int count = fields.Hex(2);
+            if (fields.Error() != FrameError::None) return fields.Error();
+            if (length < HEADER_SIZE + count * SAMPLE_WIDTH) return FrameError::Truncated;
+            if (length > HEADER_SIZE + count * SAMPLE_WIDTH) return FrameError::InvalidNumber;
+            for (int i = 0; i < count; i++)
+            {
+                if (MessageFields::Parse(message + HEADER_SIZE + i * SAMPLE_WIDTH, SAMPLE_WIDTH, 16) < 0) return FrameError::InvalidNumber;
+            }
+            sweep.finger = finger;
+            sweep.firstRealAngle = firstRealAngle;
+            sweep.count = static_cast<std::size_t>(count);
+            sweep.samples = message + HEADER_SIZE;
+            return FrameError::None;
+        }
+
+        /// @brief Write a sweep as a message without the '#' terminator
+        /// @param out Room for HEADER_SIZE + count * SAMPLE_WIDTH characters
+        /// @return The length of the message, 0 if count is above MAX_SAMPLES
+        static std::size_t Encode(int finger, int firstRealAngle, const int* angles, std::size_t count, char* out)
+        {
+            if (count > MAX_SAMPLES) return 0;
+            out[0] = 'N';
+            out[1] = 'B';
+            WriteDigits(out + 2, 2, 16, finger);
+            WriteDigits(out + 4, 3, 10, firstRealAngle);
+            WriteDigits(out + 7, 2, 16, static_cast<int>(count));
+            for (std::size_t i = 0; i < count; i++)
+            {
+                int angle = angles[i] < 0 ? 0 : (angles[i] > MAX_ANGLE ? MAX_ANGLE : angles[i]);
+                WriteDigits(out + HEADER_SIZE + i * SAMPLE_WIDTH, SAMPLE_WIDTH, 16, angle);
+            }
+            return HEADER_SIZE + count * SAMPLE_WIDTH;
+        }
+
+    private:
+        static void WriteDigits(char* out, std::size_t width, int base, int value)
+        {
+            static const char digits[] = "0123456789abcdef";
+            for (std::size_t i = width; i > 0; i--)
+            {
+                out[i - 1] = digits[value % base];
+                value /= base;
+            }
+        }
+    };
+}
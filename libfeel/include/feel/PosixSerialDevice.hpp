@@ -0,0 +1,484 @@
+#pragma once
+#if defined(__linux__)
+#include "feel/Device.hpp"
+#include "feel/CoalescingQueue.hpp"
+#include "feel/MessageQueue.hpp"
+#include "feel/ReceiveListener.hpp"
+#include "feel/Log.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <termios.h>
+#include <unistd.h>
+#include <linux/serial.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+
+namespace feel
+{
+    /// @brief Serial device for Linux
+    ///
+    /// Reading and writing is driven by a single epoll loop on one thread.
+    /// The port is put into raw mode and, where the driver supports it,
+    /// into low latency mode with the smallest USB latency timer,
+    /// so incoming frames are not held back by the kernel or the adapter.
+    class PosixSerialDevice : public Device
+    {
+    public:
+        PosixSerialDevice() :
+            status(DeviceStatus::Disconnected),
+            running(false),
+            wakePending(false)
+        {}
+
+        ~PosixSerialDevice()
+        {
+            Disconnect();
+        }
+
+        DeviceStatus GetStatus() override
+        {
+            return status;
+        }
+
+        void Connect(const char* deviceName) override
+        {
+            if (status != DeviceStatus::Disconnected) return;
+            if (ioWorker.joinable())
+            {
+                // The previous connection was lost on the I/O thread
+                ioWorker.join();
+                Close();
+            }
+
+            status = DeviceStatus::Connecting;
+            if (!Open(deviceName))
+            {
+                Close();
+                status = DeviceStatus::Disconnected;
+                return;
+            }
+            portName = deviceName;
+            running = true;
+            status = DeviceStatus::Connected;
+            ioWorker = std::thread(&PosixSerialDevice::IoThread, this);
+        }
+
+        void Disconnect() override
+        {
+            running = false;
+            if (ioWorker.joinable())
+            {
+                Wake();
+                ioWorker.join();
+            }
+            Close();
+            status = DeviceStatus::Disconnected;
+        }
+
+        void GetAvailableDevices(std::vector<std::string>& devices) override
+        {
+            DIR* dir = opendir("/sys/class/tty");
+            if (dir == nullptr) return;
+            std::vector<std::string> found;
+            while (dirent* entry = readdir(dir))
+            {
+                std::string name = entry->d_name;
+                if (name == "." || name == "..") continue;
+                std::string base = "/sys/class/tty/" + name + "/device";
+                // Virtual terminals and pseudo terminals have no backing device
+                if (access(base.c_str(), F_OK) != 0) continue;
+                // The 8250 driver registers placeholder ports whether hardware exists or not
+                if (DriverName(base) == "serial8250") continue;
+                found.emplace_back("/dev/" + name);
+            }
+            closedir(dir);
+            std::sort(found.begin(), found.end());
+            devices.insert(devices.end(), found.begin(), found.end());
+        }
+
+        /// @brief The vendor, product and serial number of USB adapters, the port name otherwise
+        std::string GetDeviceIdentifier() override
+        {
+            if (portName.empty()) return "";
+            std::string name = portName.substr(portName.rfind('/') + 1);
+            char resolved[PATH_MAX];
+            if (realpath(("/sys/class/tty/" + name + "/device").c_str(), resolved) == nullptr) return portName;
+            // The USB device owning the serial interface is one of the parents
+            std::string directory = resolved;
+            while (directory.compare(0, 13, "/sys/devices/") == 0)
+            {
+                std::string serial = ReadAttribute(directory + "/serial");
+                if (!serial.empty())
+                {
+                    return "usb:" + ReadAttribute(directory + "/idVendor") + ":" + ReadAttribute(directory + "/idProduct") + ":" + serial;
+                }
+                directory.erase(directory.rfind('/'));
+            }
+            return portName;
+        }
+
+        void TransmitMessage(std::string identifier, std::string payload = "") override
+        {
+            CommandBuffer command;
+            if (!command.Assign(identifier.data(), identifier.size(), payload.data(), payload.size()))
+            {
+                Logger::Default().Format(LogLevel::Warning, "Message too long: %s", identifier.c_str());
+                return;
+            }
+            TransmitMessage(command);
+        }
+
+        void TransmitMessage(const CommandBuffer& command) override
+        {
+            if (!outputs.TryPush(command, EnqueueTime())) return;
+            Wake();
+        }
+
+        void TransmitMessages(const CommandBuffer* commands, std::size_t count) override
+        {
+            if (outputs.TryPush(commands, count, EnqueueTime()) == 0) return;
+            Wake();
+        }
+
+        void IterateAllMessages(std::function<void(const std::string&)> callback) override
+        {
+            inputs.Drain([&](const ReceivedMessage& message)
+            {
+                inputMessage.assign(message.data, message.length);
+                callback(inputMessage);
+            });
+        }
+
+        void IterateReceivedMessages(std::function<void(const ReceivedMessage&)> callback) override
+        {
+            inputs.Drain(callback);
+        }
+
+        void DrainMessages(MessageBatch& batch) override
+        {
+            batch.Clear();
+            inputs.DrainInto(batch);
+        }
+
+        bool SetReceiveListener(std::function<void()> listener) override
+        {
+            receiveListener.Set(listener);
+            return true;
+        }
+
+        bool SetInstrumentation(bool enabled) override
+        {
+            if (enabled) sendLatency.Reset();
+            instrumented = enabled;
+            return true;
+        }
+
+        LatencyHistogramData GetSendLatency() override
+        {
+            return sendLatency.Data();
+        }
+
+        DeviceStatistics GetStatistics() override
+        {
+            DeviceStatistics statistics;
+            statistics.inputOverflows = inputs.OverflowCount();
+            statistics.outputOverflows = outputs.OverflowCount();
+            statistics.coalescedOutputs = outputs.CoalescedCount();
+            return statistics;
+        }
+
+    private:
+        static constexpr std::size_t READ_BUFFER_SIZE = 4096;
+        static constexpr std::size_t WRITE_BATCH_SIZE = 64;
+        static constexpr std::size_t WRITE_BUFFER_SIZE = WRITE_BATCH_SIZE * CommandBuffer::CAPACITY;
+
+        std::atomic<DeviceStatus> status;
+        std::atomic<bool> running;
+        std::atomic<bool> wakePending;
+        int fd = -1;
+        int epollFd = -1;
+        int wakeFd = -1;
+        std::thread ioWorker;
+        MessageQueue inputs;
+        ReceiveListener receiveListener;
+        CoalescingQueue<256> outputs;
+        std::atomic<bool> instrumented{ false };
+        LatencyHistogram sendLatency;
+        std::string inputMessage;
+        std::string portName;
+
+        // Only touched by the I/O thread
+        char readBuffer[READ_BUFFER_SIZE];
+        std::size_t readSize = 0;
+        CommandBuffer writeCommands[WRITE_BATCH_SIZE];
+        std::chrono::steady_clock::time_point writeEnqueued[WRITE_BATCH_SIZE];
+        char writeBuffer[WRITE_BUFFER_SIZE];
+        std::size_t writeOffset = 0;
+        std::size_t writeSize = 0;
+        bool waitingForWritable = false;
+
+        static std::string DriverName(const std::string& devicePath)
+        {
+            char target[PATH_MAX];
+            ssize_t length = readlink((devicePath + "/driver").c_str(), target, sizeof(target) - 1);
+            if (length <= 0) return "";
+            target[length] = '\0';
+            const char* name = std::strrchr(target, '/');
+            return name ? name + 1 : target;
+        }
+
+        static std::string ReadAttribute(const std::string& path)
+        {
+            std::ifstream file(path);
+            std::string value;
+            std::getline(file, value);
+            return value;
+        }
+
+        bool Open(const char* deviceName)
+        {
+            fd = open(deviceName, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+            if (fd < 0)
+            {
+                Logger::Default().Format(LogLevel::Error, "%s: %s", deviceName, std::strerror(errno));
+                return false;
+            }
+            ioctl(fd, TIOCEXCL);
+
+            termios tty;
+            if (tcgetattr(fd, &tty) != 0)
+            {
+                Logger::Default().Format(LogLevel::Error, "%s: %s", deviceName, std::strerror(errno));
+                return false;
+            }
+            cfmakeraw(&tty);
+            tty.c_cflag |= CLOCAL | CREAD;
+            tty.c_cflag &= ~(CSTOPB | CRTSCTS);
+            // Reads are non-blocking and driven by epoll, so do not let the
+            // line discipline wait for a minimum count or an inter-byte timer.
+            tty.c_cc[VMIN] = 0;
+            tty.c_cc[VTIME] = 0;
+            cfsetispeed(&tty, B115200);
+            cfsetospeed(&tty, B115200);
+            if (tcsetattr(fd, TCSANOW, &tty) != 0)
+            {
+                Logger::Default().Format(LogLevel::Error, "%s: %s", deviceName, std::strerror(errno));
+                return false;
+            }
+            tcflush(fd, TCIOFLUSH);
+
+            serial_struct serial;
+            if (ioctl(fd, TIOCGSERIAL, &serial) == 0)
+            {
+                serial.flags |= ASYNC_LOW_LATENCY;
+                ioctl(fd, TIOCSSERIAL, &serial);
+            }
+            SetLatencyTimer(deviceName);
+
+            epollFd = epoll_create1(EPOLL_CLOEXEC);
+            wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (epollFd < 0 || wakeFd < 0) return false;
+            epoll_event event = {};
+            event.events = EPOLLIN;
+            event.data.fd = wakeFd;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event) != 0) return false;
+            event.events = EPOLLIN;
+            event.data.fd = fd;
+            if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) != 0) return false;
+
+            readSize = 0;
+            writeOffset = 0;
+            writeSize = 0;
+            waitingForWritable = false;
+            wakePending = false;
+            return true;
+        }
+
+        // USB serial adapters (e.g. FTDI) buffer incoming bytes for up to
+        // 16ms by default before passing them on; 1ms is the minimum.
+        static void SetLatencyTimer(const char* deviceName)
+        {
+            const char* name = std::strrchr(deviceName, '/');
+            name = name ? name + 1 : deviceName;
+            std::ofstream timer(std::string("/sys/bus/usb-serial/devices/") + name + "/latency_timer");
+            if (timer)
+            {
+                timer << 1;
+            }
+        }
+
+        void Close()
+        {
+            if (epollFd >= 0) close(epollFd);
+            if (wakeFd >= 0) close(wakeFd);
+            if (fd >= 0) close(fd);
+            epollFd = -1;
+            wakeFd = -1;
+            fd = -1;
+        }
+
+        // Reading the clock is only worth it while instrumented
+        std::chrono::steady_clock::time_point EnqueueTime() const
+        {
+            if (!instrumented.load(std::memory_order_relaxed)) return std::chrono::steady_clock::time_point();
+            return std::chrono::steady_clock::now();
+        }
+
+        void RecordSendLatency(const std::chrono::steady_clock::time_point* enqueued, std::size_t count)
+        {
+            if (!instrumented.load(std::memory_order_relaxed)) return;
+            auto now = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < count; i++)
+            {
+                // Queued before the instrumentation was enabled
+                if (enqueued[i] == std::chrono::steady_clock::time_point()) continue;
+                sendLatency.Record(now - enqueued[i]);
+            }
+        }
+
+        void Wake()
+        {
+            // Only the first message after the I/O thread went idle needs a syscall
+            if (wakeFd >= 0 && !wakePending.exchange(true))
+            {
+                std::uint64_t one = 1;
+                ssize_t result = write(wakeFd, &one, sizeof(one));
+                (void)result;
+            }
+        }
+
+        void IoThread()
+        {
+            epoll_event events[4];
+            while (running)
+            {
+                if (!Flush()) break;
+                int count = epoll_wait(epollFd, events, 4, -1);
+                if (count < 0)
+                {
+                    if (errno == EINTR) continue;
+                    break;
+                }
+                bool failed = false;
+                for (int i = 0; i < count; i++)
+                {
+                    if (events[i].data.fd == wakeFd)
+                    {
+                        std::uint64_t value;
+                        ssize_t result = read(wakeFd, &value, sizeof(value));
+                        (void)result;
+                        wakePending.exchange(false);
+                        continue;
+                    }
+                    if (events[i].events & (EPOLLERR | EPOLLHUP))
+                    {
+                        failed = true;
+                    }
+                    if (events[i].events & EPOLLIN)
+                    {
+                        failed |= !Receive();
+                    }
+                }
+                if (failed)
+                {
+                    Logger::Default().Write(LogLevel::Error, "Serial connection lost");
+                    status = DeviceStatus::Disconnected;
+                    receiveListener.Notify();
+                    break;
+                }
+            }
+        }
+
+        bool Receive()
+        {
+            while (true)
+            {
+                ssize_t received = read(fd, readBuffer + readSize, READ_BUFFER_SIZE - readSize);
+                if (received < 0)
+                {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) return true;
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                // With VMIN and VTIME at 0 an empty port reads as 0 bytes,
+                // a hang up is reported through EPOLLHUP instead.
+                if (received == 0) return true;
+
+                auto timestamp = std::chrono::steady_clock::now();
+                std::size_t scanFrom = readSize;
+                readSize += received;
+                std::size_t messageStart = 0;
+                for (std::size_t i = scanFrom; i < readSize; i++)
+                {
+                    if (readBuffer[i] != '#') continue;
+                    inputs.TryPush(readBuffer + messageStart, i - messageStart, timestamp);
+                    messageStart = i + 1;
+                }
+                if (messageStart > 0)
+                {
+                    receiveListener.Notify();
+                    std::memmove(readBuffer, readBuffer + messageStart, readSize - messageStart);
+                    readSize -= messageStart;
+                }
+                else if (readSize == READ_BUFFER_SIZE)
+                {
+                    // No terminator in a full buffer, this is line noise
+                    readSize = 0;
+                }
+            }
+        }
+
+        bool Flush()
+        {
+            while (true)
+            {
+                if (writeOffset == writeSize)
+                {
+                    writeOffset = 0;
+                    writeSize = 0;
+                    // Gather everything pending into one write
+                    std::size_t count = outputs.TryPopAll(writeCommands, WRITE_BATCH_SIZE, writeEnqueued);
+                    for (std::size_t i = 0; i < count; i++)
+                    {
+                        std::memcpy(writeBuffer + writeSize, writeCommands[i].Data(), writeCommands[i].Size());
+                        writeSize += writeCommands[i].Size();
+                    }
+                    RecordSendLatency(writeEnqueued, count);
+                    if (writeSize == 0) break;
+                }
+                ssize_t written = write(fd, writeBuffer + writeOffset, writeSize - writeOffset);
+                if (written < 0)
+                {
+                    if (errno == EINTR) continue;
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                    return false;
+                }
+                writeOffset += written;
+            }
+
+            bool needWritable = writeOffset != writeSize;
+            if (needWritable != waitingForWritable)
+            {
+                epoll_event event = {};
+                event.events = EPOLLIN | (needWritable ? std::uint32_t(EPOLLOUT) : std::uint32_t(0));
+                event.data.fd = fd;
+                epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+                waitingForWritable = needWritable;
+            }
+            return true;
+        }
+    };
+}
+#endif
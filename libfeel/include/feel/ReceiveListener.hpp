@@ -0,0 +1,34 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+namespace feel
+{
+    /// @brief Holds the function a device calls after it received messages
+    ///
+    /// Notify() is called on the receiving thread, Set() may be called
+    /// from any thread and does not return while the listener is running.
+    class ReceiveListener
+    {
+    public:
+        void Set(std::function<void()> function)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            listener = function;
+            active.store(static_cast<bool>(listener), std::memory_order_relaxed);
+        }
+
+        void Notify()
+        {
+            if (!active.load(std::memory_order_relaxed)) return;
+            std::lock_guard<std::mutex> lock(mutex);
+            if (listener) listener();
+        }
+
+    private:
+        std::mutex mutex;
+        std::function<void()> listener;
+        std::atomic<bool> active{ false };
+    };
+}
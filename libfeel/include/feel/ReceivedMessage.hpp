@@ -0,0 +1,29 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace feel
+{
+    /// @brief A view of a message received from a device
+    ///
+    /// The data is only valid during the callback it was passed to.
+    struct ReceivedMessage
+    {
+        const char* data;
+        std::size_t length;
+        /// @brief When the device received the message
+        std::chrono::steady_clock::time_point timestamp;
+    };
+
+    /// @brief Copy a part of a message, like std::string::substr()
+    ///
+    /// The fields of the glove's messages are short enough for the
+    /// small string optimization, so this does not allocate for them.
+    inline std::string MessageField(const ReceivedMessage& message, std::size_t offset, std::size_t length = std::string::npos)
+    {
+        if (offset > message.length) offset = message.length;
+        if (length > message.length - offset) length = message.length - offset;
+        return std::string(message.data + offset, length);
+    }
+}
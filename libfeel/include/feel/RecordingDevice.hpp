@@ -0,0 +1,177 @@
+#pragma once
+#include "feel/Device.hpp"
+#include "feel/CaptureFile.hpp"
+#include <memory>
+#include <mutex>
+
+namespace feel
+{
+    /// @brief Records everything another device receives and sends into a capture file
+    ///
+    /// Wrap the real device into it, e.g. Feel(new RecordingDevice(new SerialDevice())),
+    /// and call StartRecording(). Received messages are recorded with the time
+    /// the underlying device received them, sent ones with the time they were
+    /// handed to the device. The capture can be played back with ReplayDevice.
+    class RecordingDevice : public Device
+    {
+    public:
+        /// @param device The device to record.
+        /// @note The given device will be deleted in the destructor.
+        explicit RecordingDevice(Device* device) :
+            device(device)
+        {}
+
+        ~RecordingDevice()
+        {
+            // Stop the device first, it may still call the listener
+            device->Disconnect();
+        }
+
+        /// @brief Start writing a new capture
+        /// @return false if the file could not be created
+        bool StartRecording(const char* fileName)
+        {
+            std::lock_guard<std::mutex> lock(writerMutex);
+            return writer.Open(fileName);
+        }
+
+        /// @brief Finish the capture, the file is complete afterwards
+        void StopRecording()
+        {
+            std::lock_guard<std::mutex> lock(writerMutex);
+            writer.Close();
+        }
+
+        bool IsRecording()
+        {
+            std::lock_guard<std::mutex> lock(writerMutex);
+            return writer.IsOpen();
+        }
+
+        /// @brief The recorded device
+        Device& GetDevice()
+        {
+            return *device;
+        }
+
+        DeviceStatus GetStatus() override
+        {
+            return device->GetStatus();
+        }
+
+        void Connect(const char* deviceName) override
+        {
+            device->Connect(deviceName);
+        }
+
+        void Disconnect() override
+        {
+            device->Disconnect();
+            std::lock_guard<std::mutex> lock(writerMutex);
+            writer.Flush();
+        }
+
+        void GetAvailableDevices(std::vector<std::string>& devices) override
+        {
+            device->GetAvailableDevices(devices);
+        }
+
+        void TransmitMessage(std::string identifier, std::string payload = "") override
+        {
+            CommandBuffer command;
+            if (!command.Assign(identifier.data(), identifier.size(), payload.data(), payload.size()))
+            {
+                // Too long for a frame, passed on as it is
+                Record(CaptureDirection::Outbound, std::chrono::steady_clock::now(), (identifier + payload).data(), identifier.size() + payload.size());
+                device->TransmitMessage(identifier, payload);
+                return;
+            }
+            TransmitMessage(command);
+        }
+
+        void TransmitMessage(const CommandBuffer& command) override
+        {
+            Record(CaptureDirection::Outbound, std::chrono::steady_clock::now(), command.Data(), command.MessageSize());
+            device->TransmitMessage(command);
+        }
+
+        void TransmitMessages(const CommandBuffer* commands, std::size_t count) override
+        {
+            {
+                auto now = std::chrono::steady_clock::now();
+                std::lock_guard<std::mutex> lock(writerMutex);
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    writer.Write(CaptureDirection::Outbound, now, commands[i].Data(), commands[i].MessageSize());
+                }
+            }
+            device->TransmitMessages(commands, count);
+        }
+
+        void IterateAllMessages(std::function<void(const std::string&)> callback) override
+        {
+            IterateReceivedMessages([&](const ReceivedMessage& message)
+            {
+                inputMessage.assign(message.data, message.length);
+                callback(inputMessage);
+            });
+        }
+
+        void IterateReceivedMessages(std::function<void(const ReceivedMessage&)> callback) override
+        {
+            device->IterateReceivedMessages([&](const ReceivedMessage& message)
+            {
+                Record(CaptureDirection::Inbound, message.timestamp, message.data, message.length);
+                callback(message);
+            });
+        }
+
+        void DrainMessages(MessageBatch& batch) override
+        {
+            device->DrainMessages(batch);
+            std::lock_guard<std::mutex> lock(writerMutex);
+            for (const ReceivedMessage& message : batch)
+            {
+                writer.Write(CaptureDirection::Inbound, message.timestamp, message.data, message.length);
+            }
+        }
+
+        bool SetReceiveListener(std::function<void()> listener) override
+        {
+            return device->SetReceiveListener(listener);
+        }
+
+        bool SetInstrumentation(bool enabled) override
+        {
+            return device->SetInstrumentation(enabled);
+        }
+
+        LatencyHistogramData GetSendLatency() override
+        {
+            return device->GetSendLatency();
+        }
+
+        std::string GetDeviceIdentifier() override
+        {
+            return device->GetDeviceIdentifier();
+        }
+
+        DeviceStatistics GetStatistics() override
+        {
+            return device->GetStatistics();
+        }
+
+    private:
+        std::unique_ptr<Device> device;
+        // Messages are sent and received on different threads
+        std::mutex writerMutex;
+        CaptureWriter writer;
+        std::string inputMessage;
+
+        void Record(CaptureDirection direction, std::chrono::steady_clock::time_point timestamp, const char* data, std::size_t length)
+        {
+            std::lock_guard<std::mutex> lock(writerMutex);
+            writer.Write(direction, timestamp, data, length);
+        }
+    };
+}
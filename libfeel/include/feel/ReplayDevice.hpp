@@ -0,0 +1,205 @@
+#pragma once
+#include "feel/Device.hpp"
+#include "feel/CaptureFile.hpp"
+#include "feel/Log.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace feel
+{
+    struct ReplaySettings
+    {
+        /// @brief Playback speed relative to the recording, 2 plays twice as fast.
+        /// 0 plays as fast as the messages are consumed.
+        double speed = 1;
+        /// @brief The most messages a single IterateReceivedMessages() call delivers
+        std::size_t batchSize = 4096;
+    };
+
+    /// @brief Plays back the messages received in a capture written by RecordingDevice
+    ///
+    /// Connect() takes the file name of the capture. The messages are delivered
+    /// straight out of the memory mapped file, once they are due, whenever
+    /// messages are iterated, so playback neither copies, allocates nor needs a
+    /// thread. The recorded outbound messages are skipped and messages sent to
+    /// the device are discarded.
+    ///
+    /// Messages are timestamped with the time they are due, so the
+    /// recorded spacing (scaled by the speed) is preserved. When playing as
+    /// fast as possible the spacing is kept as recorded.
+    class ReplayDevice : public Device
+    {
+    public:
+        ReplayDevice(ReplaySettings settings = ReplaySettings()) :
+            settings(settings),
+            status(DeviceStatus::Disconnected),
+            finished(false),
+            hasPending(false),
+            replayed(0),
+            transmitted(0)
+        {}
+
+        DeviceStatus GetStatus() override
+        {
+            return status;
+        }
+
+        void Connect(const char* deviceName) override
+        {
+            if (status != DeviceStatus::Disconnected) return;
+            status = DeviceStatus::Connecting;
+            if (!reader.Open(deviceName))
+            {
+                Logger::Default().Format(LogLevel::Error, "Cannot open capture: %s", deviceName);
+                status = DeviceStatus::Disconnected;
+                return;
+            }
+            replayed = 0;
+            Restart();
+            status = DeviceStatus::Connected;
+        }
+
+        void Disconnect() override
+        {
+            status = DeviceStatus::Disconnected;
+            reader.Close();
+            hasPending = false;
+        }
+
+        void GetAvailableDevices(std::vector<std::string>& /*devices*/) override
+        {
+        }
+
+        /// @brief Play the capture again from the start
+        void Restart()
+        {
+            reader.Rewind();
+            start = std::chrono::steady_clock::now();
+            finished = false;
+            hasPending = false;
+        }
+
+        /// @brief Whether all messages of the capture were delivered
+        bool Finished() const
+        {
+            return finished;
+        }
+
+        /// @brief How much of the capture was played, 0 - 1
+        double GetProgress() const
+        {
+            return reader.Progress();
+        }
+
+        /// @brief The number of messages delivered since Connect()
+        std::uint64_t GetReplayedCount() const
+        {
+            return replayed;
+        }
+
+        /// @brief The number of messages sent to the device
+        std::uint64_t GetTransmittedCount() const
+        {
+            return transmitted;
+        }
+
+        void TransmitMessage(std::string /*identifier*/, std::string /*payload*/ = "") override
+        {
+            transmitted++;
+        }
+
+        void TransmitMessage(const CommandBuffer& /*command*/) override
+        {
+            transmitted++;
+        }
+
+        void TransmitMessages(const CommandBuffer* /*commands*/, std::size_t count) override
+        {
+            transmitted += count;
+        }
+
+        void IterateAllMessages(std::function<void(const std::string&)> callback) override
+        {
+            IterateReceivedMessages([&](const ReceivedMessage& message)
+            {
+                inputMessage.assign(message.data, message.length);
+                callback(inputMessage);
+            });
+        }
+
+        void IterateReceivedMessages(std::function<void(const ReceivedMessage&)> callback) override
+        {
+            Play(callback);
+        }
+
+        /// @brief The messages refer directly to the mapped capture
+        void DrainMessages(MessageBatch& batch) override
+        {
+            batch.Clear();
+            Play([&batch](const ReceivedMessage& message)
+            {
+                batch.AppendView(message);
+            });
+        }
+
+    private:
+        const ReplaySettings settings;
+        std::atomic<DeviceStatus> status;
+        CaptureReader reader;
+        std::chrono::steady_clock::time_point start;
+        std::atomic<bool> finished;
+        CaptureRecord pending;
+        bool hasPending;
+        std::atomic<std::uint64_t> replayed;
+        std::atomic<std::uint64_t> transmitted;
+        std::string inputMessage;
+
+        // Calls deliver(const ReceivedMessage&) for every message that is due
+        template<typename Deliver>
+        void Play(Deliver&& deliver)
+        {
+            if (status != DeviceStatus::Connected) return;
+            bool paced = settings.speed > 0;
+            auto now = paced ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+            for (std::size_t delivered = 0; delivered < settings.batchSize;)
+            {
+                // A message that was not due yet is kept for the next call
+                if (!hasPending && !NextInbound(pending))
+                {
+                    finished = true;
+                    return;
+                }
+                hasPending = false;
+                auto due = DueTime(pending.offsetMicroseconds);
+                if (paced && due > now)
+                {
+                    hasPending = true;
+                    return;
+                }
+                deliver(ReceivedMessage{ pending.data, pending.length, due });
+                replayed++;
+                delivered++;
+            }
+        }
+
+        bool NextInbound(CaptureRecord& record)
+        {
+            while (reader.Next(record))
+            {
+                if (record.direction == CaptureDirection::Inbound) return true;
+            }
+            return false;
+        }
+
+        std::chrono::steady_clock::time_point DueTime(std::int64_t offsetMicroseconds) const
+        {
+            if (settings.speed <= 0 || settings.speed == 1)
+            {
+                return start + std::chrono::microseconds(offsetMicroseconds);
+            }
+            return start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double, std::micro>(offsetMicroseconds / settings.speed));
+        }
+    };
+}
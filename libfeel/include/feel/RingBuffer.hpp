@@ -0,0 +1,113 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace feel
+{
+    /// @brief Bounded single-producer/single-consumer ring buffer.
+    ///
+    /// Exactly one thread may push and exactly one thread may pop.
+    /// Both sides are wait-free, pushes into a full buffer fail
+    /// and are counted as overflows.
+    template<typename T, std::size_t Capacity>
+    class RingBuffer
+    {
+        static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        RingBuffer() :
+            head(0),
+            tail(0),
+            overflows(0)
+        {}
+
+        RingBuffer(const RingBuffer&) = delete;
+        RingBuffer& operator=(const RingBuffer&) = delete;
+
+        /// @brief Producer: append one item
+        /// @return false if the buffer was full
+        bool TryPush(const T& item)
+        {
+            return TryPush(&item, 1);
+        }
+
+        /// @brief Producer: append all items or none of them
+        /// @return false if there was not enough free space
+        bool TryPush(const T* items, std::size_t count)
+        {
+            std::size_t t = tail.load(std::memory_order_relaxed);
+            std::size_t h = head.load(std::memory_order_acquire);
+            if (count > Capacity - (t - h))
+            {
+                overflows.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            for (std::size_t i = 0; i < count; i++)
+            {
+                slots[(t + i) & (Capacity - 1)] = items[i];
+            }
+            tail.store(t + count, std::memory_order_release);
+            return true;
+        }
+
+        /// @brief Consumer: remove the oldest item
+        /// @return false if the buffer was empty
+        bool TryPop(T& item)
+        {
+            std::size_t h = head.load(std::memory_order_relaxed);
+            if (h == tail.load(std::memory_order_acquire)) return false;
+            item = slots[h & (Capacity - 1)];
+            head.store(h + 1, std::memory_order_release);
+            return true;
+        }
+
+        /// @brief Consumer: number of items that can be read
+        std::size_t Available() const
+        {
+            return tail.load(std::memory_order_acquire) - head.load(std::memory_order_relaxed);
+        }
+
+        /// @brief Consumer: access the item at offset from the oldest one
+        /// @pre offset < Available()
+        const T& Peek(std::size_t offset) const
+        {
+            return slots[(head.load(std::memory_order_relaxed) + offset) & (Capacity - 1)];
+        }
+
+        /// @brief Consumer: drop the oldest count items
+        /// @pre count <= Available()
+        void Pop(std::size_t count)
+        {
+            head.store(head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        }
+
+        /// @brief Producer: number of items that can be pushed
+        std::size_t Free() const
+        {
+            return Capacity - (tail.load(std::memory_order_relaxed) - head.load(std::memory_order_acquire));
+        }
+
+        bool Empty() const
+        {
+            return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+        }
+
+        /// @brief How many pushes failed because the buffer was full
+        std::uint64_t OverflowCount() const
+        {
+            return overflows.load(std::memory_order_relaxed);
+        }
+
+    private:
+        // head and tail live on separate cache lines, so producer
+        // and consumer do not invalidate each other on every operation.
+        std::atomic<std::size_t> head;
+        char headPadding[64 - sizeof(std::atomic<std::size_t>)];
+        std::atomic<std::size_t> tail;
+        char tailPadding[64 - sizeof(std::atomic<std::size_t>)];
+        std::atomic<std::uint64_t> overflows;
+        std::array<T, Capacity> slots;
+    };
+}
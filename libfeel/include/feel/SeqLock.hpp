@@ -0,0 +1,99 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <type_traits>
+
+namespace feel
+{
+    /// @brief A value with a single writer and any number of readers that never block it
+    ///
+    /// The writer makes the sequence odd, writes the value and makes it even again.
+    /// A reader copies the value and keeps the copy only if the sequence was even and
+    /// did not change meanwhile, so it always gets a value that was stored as a whole.
+    /// Neither side takes a lock, a reader never delays the writer.
+    ///
+    /// The value is kept in lock-free atomic words and the class holds no pointers,
+    /// so it also works when placed into memory shared between processes.
+    template<typename T>
+    class SeqLock
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+
+    public:
+        static constexpr std::size_t WORD_COUNT = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+
+        SeqLock() :
+            sequence(0)
+        {
+            for (std::atomic<std::uint64_t>& word : words)
+            {
+                word.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        SeqLock(const SeqLock&) = delete;
+        SeqLock& operator=(const SeqLock&) = delete;
+
+        /// @brief Replace the value, only one thread may store
+        void Store(const T& value)
+        {
+            std::array<std::uint64_t, WORD_COUNT> buffer = {};
+            std::memcpy(buffer.data(), &value, sizeof(T));
+            std::uint64_t start = sequence.load(std::memory_order_relaxed);
+            sequence.store(start + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for (std::size_t i = 0; i < WORD_COUNT; i++)
+            {
+                words[i].store(buffer[i], std::memory_order_relaxed);
+            }
+            sequence.store(start + 2, std::memory_order_release);
+        }
+
+        /// @brief Make a single attempt to read the value, wait-free
+        /// @return false if a store was in progress, value is unchanged then
+        bool TryLoad(T& value) const
+        {
+            std::uint64_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1) return false;
+            std::array<std::uint64_t, WORD_COUNT> buffer;
+            for (std::size_t i = 0; i < WORD_COUNT; i++)
+            {
+                buffer[i] = words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sequence.load(std::memory_order_relaxed) != before) return false;
+            std::memcpy(&value, buffer.data(), sizeof(T));
+            return true;
+        }
+
+        /// @brief Read the value, retrying while stores are in progress
+        ///
+        /// Stores take well below a microsecond, so the first or second attempt
+        /// usually succeeds. The attempts are bounded in case the writer was
+        /// stopped in the middle of a store, e.g. because its process died.
+        /// @return false if no attempt succeeded, value is unchanged then
+        bool Load(T& value, std::size_t attempts = 1000) const
+        {
+            for (std::size_t i = 0; i < attempts; i++)
+            {
+                if (TryLoad(value)) return true;
+                if (i >= 16) std::this_thread::yield();
+            }
+            return false;
+        }
+
+        /// @brief Changes with every store, 0 until the first one
+        std::uint64_t Version() const
+        {
+            return sequence.load(std::memory_order_acquire) / 2;
+        }
+
+    private:
+        std::atomic<std::uint64_t> sequence;
+        std::array<std::atomic<std::uint64_t>, WORD_COUNT> words;
+    };
+}
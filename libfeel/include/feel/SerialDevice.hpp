@@ -1,37 +1,53 @@
 #pragma once
 #include "feel/Device.hpp"
-#define ASIO_STANDALONE
-#include "asio.hpp"
-#include <thread>
-#include <queue>
-#include <iostream>
-#include <sstream>
+#include "feel/CoalescingQueue.hpp"
+#include "feel/MessageQueue.hpp"
+#include "feel/ReceiveListener.hpp"
+#include "feel/Log.hpp"
+#include "feel/SerialIoContext.hpp"
+#include <array>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
 #include <atomic>
 #include <Windows.h>
 #include <winreg.h>
 
 namespace feel
 {
+	/// @brief Serial device using asio
+	///
+	/// Reading and writing are chains of asynchronous operations on the
+	/// threads of a SerialIoContext, no thread is blocked per port.
 	class SerialDevice : public Device
 	{
 	public:
+        /// @brief Creates a device doing its I/O on a thread of its own
 		SerialDevice() :
-			inputs(),
-			io(),
-			serial(io),
-            status(DeviceStatus::Disconnected)
+            ownContext(new SerialIoContext(1)),
+            context(*ownContext),
+			serial(context.Service()),
+            strand(context.Service()),
+            status(DeviceStatus::Disconnected),
+            writing(false),
+            operations(0)
 		{}
 
+        /// @brief Creates a device doing its I/O on the threads of a shared context
+        /// @param context The context to use, it must outlive the device.
+        explicit SerialDevice(SerialIoContext& context) :
+            context(context),
+            serial(context.Service()),
+            strand(context.Service()),
+            status(DeviceStatus::Disconnected),
+            writing(false),
+            operations(0)
+        {}
+
 		~SerialDevice()
 		{
-            if (writeWorker.joinable())
-            {
-                writeWorker.join();
-            }
-            if (readWorker.joinable())
-            {
-                readWorker.join();
-            }
+            Disconnect();
 		}
 
         DeviceStatus GetStatus() override
@@ -43,36 +59,55 @@ namespace feel
 		{
 		    if (status == DeviceStatus::Disconnected)
 			{
+                // A connection lost on the I/O threads may still be shutting down
+                WaitForOperations();
                 status = DeviceStatus::Connecting;
                 try
                 {
                     serial.open(deviceName);
                     serial.set_option(asio::serial_port::baud_rate(115200));
                     serial.set_option(asio::serial_port::character_size(8));
+                    portName = deviceName;
                     status = DeviceStatus::Connected;
                 }
                 catch (const std::exception& e)
                 {
-                    std::cout << e.what() << std::endl;
+                    Logger::Default().Format(LogLevel::Error, "%s: %s", deviceName, e.what());
+                    asio::error_code ec;
+                    serial.close(ec);
                     status = DeviceStatus::Disconnected;
                     return;
                 }
-                outputFlag.test_and_set();
-                readWorker = std::thread(&SerialDevice::ReadingThread, this);
-                writeWorker = std::thread(&SerialDevice::WritingThread, this);
+                StartOperation();
+                strand.post([this]()
+                {
+                    ReadSerial();
+                });
+                // Send what was queued before the connection was up
+                StartWriting();
 			}
 		}
 
+        /// @note Must not be called on one of the context's threads, it waits for them.
         void Disconnect() override
         {
-            if (status != DeviceStatus::Disconnected)
+            status = DeviceStatus::Disconnected;
+            StartOperation();
+            strand.post([this]()
             {
-                status = DeviceStatus::Disconnected;
-                outputFlag.clear();
-                outputCondition.notify_one();
-                writeWorker.join();
-                serial.cancel();
-            }
+                // Completes the pending reads and writes with operation_aborted
+                asio::error_code ec;
+                serial.cancel(ec);
+                serial.close(ec);
+                FinishOperation();
+            });
+            WaitForOperations();
+        }
+
+        /// @brief The name of the COM port
+        std::string GetDeviceIdentifier() override
+        {
+            return portName;
         }
 
         void GetAvailableDevices(std::vector<std::string>& devices) override
@@ -98,80 +133,232 @@ namespace feel
 
 		void IterateAllMessages(std::function<void(const std::string&)> callback) override
 		{
-			std::lock_guard<std::mutex> lock(inputMutex);
-			while (!inputs.empty())
-			{
-				callback(inputs.front());
-				inputs.pop();
-			}
+            inputs.Drain([&](const ReceivedMessage& message)
+            {
+                inputMessage.assign(message.data, message.length);
+                callback(inputMessage);
+            });
 		}
 
+        void IterateReceivedMessages(std::function<void(const ReceivedMessage&)> callback) override
+        {
+            inputs.Drain(callback);
+        }
+
+        void DrainMessages(MessageBatch& batch) override
+        {
+            batch.Clear();
+            inputs.DrainInto(batch);
+        }
+
         void TransmitMessage(std::string identifier, std::string payload = "") override
         {
+            CommandBuffer command;
+            if (!command.Assign(identifier.data(), identifier.size(), payload.data(), payload.size()))
             {
-                std::lock_guard<std::mutex> lock(outputMutex);
-                outputs.emplace(identifier + payload + "#");
+                Logger::Default().Format(LogLevel::Warning, "Message too long: %s", identifier.c_str());
+                return;
             }
-            outputCondition.notify_one();
+            TransmitMessage(command);
+        }
+
+        void TransmitMessage(const CommandBuffer& command) override
+        {
+            if (!outputs.TryPush(command, EnqueueTime())) return;
+            StartWriting();
 		}
 
+        void TransmitMessages(const CommandBuffer* commands, std::size_t count) override
+        {
+            if (outputs.TryPush(commands, count, EnqueueTime()) == 0) return;
+            StartWriting();
+        }
+
+        bool SetReceiveListener(std::function<void()> listener) override
+        {
+            receiveListener.Set(listener);
+            return true;
+        }
+
+        bool SetInstrumentation(bool enabled) override
+        {
+            if (enabled) sendLatency.Reset();
+            instrumented = enabled;
+            return true;
+        }
+
+        LatencyHistogramData GetSendLatency() override
+        {
+            return sendLatency.Data();
+        }
+
+        DeviceStatistics GetStatistics() override
+        {
+            DeviceStatistics statistics;
+            statistics.inputOverflows = inputs.OverflowCount();
+            statistics.outputOverflows = outputs.OverflowCount();
+            statistics.coalescedOutputs = outputs.CoalescedCount();
+            return statistics;
+        }
+
 	private:
-        DeviceStatus status;
-		asio::io_service io;
+        static constexpr std::size_t WRITE_BATCH_SIZE = 32;
+
+        // The first entries of writeBuffers as a buffer sequence,
+        // asio::buffer() would treat the array itself as raw memory.
+        struct BufferSequence
+        {
+            typedef asio::const_buffer value_type;
+            typedef const asio::const_buffer* const_iterator;
+
+            const_iterator first;
+            const_iterator last;
+
+            const_iterator begin() const
+            {
+                return first;
+            }
+
+            const_iterator end() const
+            {
+                return last;
+            }
+        };
+
+        // Only set when the device created its own context
+        std::unique_ptr<SerialIoContext> ownContext;
+        SerialIoContext& context;
 		asio::serial_port serial;
-		std::queue<std::string> inputs;
-        std::queue<std::string> outputs;
-		std::thread readWorker;
-        std::thread writeWorker;
-		std::mutex inputMutex;
-        std::mutex outputMutex;
-        std::atomic_flag outputFlag;
-        std::condition_variable outputCondition;
-
-        void ReadSerial(asio::streambuf& b)
-        {
-            asio::async_read_until(serial, b, '#', [&](auto ec, auto s)
+        // Serializes the handlers of this port when the context has several threads
+        asio::io_service::strand strand;
+        std::atomic<DeviceStatus> status;
+		MessageQueue inputs;
+        ReceiveListener receiveListener;
+        CoalescingQueue<256> outputs;
+        std::atomic<bool> instrumented{ false };
+        LatencyHistogram sendLatency;
+        std::string inputMessage;
+        std::string portName;
+
+        // Only touched by handlers running on the strand
+        asio::streambuf readBuffer;
+        std::array<CommandBuffer, WRITE_BATCH_SIZE> writeCommands;
+        std::array<std::chrono::steady_clock::time_point, WRITE_BATCH_SIZE> writeEnqueued;
+        std::array<asio::const_buffer, WRITE_BATCH_SIZE> writeBuffers;
+
+        // Set while a write chain is running, there is at most one per port
+        std::atomic<bool> writing;
+        // Pending asynchronous work that refers to this device
+        std::mutex operationMutex;
+        std::condition_variable operationsDone;
+        int operations;
+
+        void StartOperation()
+        {
+            std::lock_guard<std::mutex> lock(operationMutex);
+            operations++;
+        }
+
+        void FinishOperation()
+        {
+            std::lock_guard<std::mutex> lock(operationMutex);
+            if (--operations == 0)
             {
-                if (!!ec) return;
-                std::string message
+                operationsDone.notify_all();
+            }
+        }
+
+        void WaitForOperations()
+        {
+            std::unique_lock<std::mutex> lock(operationMutex);
+            operationsDone.wait(lock, [this]() { return operations == 0; });
+        }
+
+        void ReadSerial()
+        {
+            asio::async_read_until(serial, readBuffer, '#', strand.wrap([this](const asio::error_code& ec, std::size_t s)
+            {
+                if (!!ec)
                 {
-                    asio::buffers_begin(b.data()), asio::buffers_begin(b.data()) + s - 1
-                };
-                b.consume(s);
-                std::lock_guard<std::mutex> lock(inputMutex);
-                inputs.push(message);
-                ReadSerial(b);
-            });
+                    if (ec != asio::error::operation_aborted && status == DeviceStatus::Connected)
+                    {
+                        Logger::Default().Format(LogLevel::Error, "Serial connection lost: %s", ec.message().c_str());
+                        status = DeviceStatus::Disconnected;
+                        receiveListener.Notify();
+                    }
+                    FinishOperation();
+                    return;
+                }
+                inputs.TryPush(static_cast<const char*>(readBuffer.data().data()), s - 1, std::chrono::steady_clock::now());
+                readBuffer.consume(s);
+                receiveListener.Notify();
+                ReadSerial();
+            }));
         }
 
-        void ReadingThread()
+        // Reading the clock is only worth it while instrumented
+        std::chrono::steady_clock::time_point EnqueueTime() const
         {
-            asio::streambuf b;
-            ReadSerial(b);
+            if (!instrumented.load(std::memory_order_relaxed)) return std::chrono::steady_clock::time_point();
+            return std::chrono::steady_clock::now();
+        }
 
-            io.run();
+        void RecordSendLatency(const std::chrono::steady_clock::time_point* enqueued, std::size_t count)
+        {
+            if (!instrumented.load(std::memory_order_relaxed)) return;
+            auto now = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < count; i++)
+            {
+                // Queued before the instrumentation was enabled
+                if (enqueued[i] == std::chrono::steady_clock::time_point()) continue;
+                sendLatency.Record(now - enqueued[i]);
+            }
         }
 
-        void WritingThread()
+        void StartWriting()
         {
-            bool stopThread = false;
-            while (true)
+            if (status != DeviceStatus::Connected) return;
+            // Only the first message while no chain is running starts one
+            if (writing.exchange(true)) return;
+            StartOperation();
+            strand.post([this]()
             {
-                std::unique_lock<std::mutex> lock(outputMutex);
-                outputCondition.wait(lock, [&]
-                {
-                    return !outputs.empty() || stopThread || (stopThread = !outputFlag.test_and_set());
-                });
-                if (outputs.empty() && stopThread)
+                WriteNext();
+            });
+        }
+
+        void WriteNext()
+        {
+            // Send everything that piled up during the last write with one gathered write
+            std::size_t count = outputs.TryPopAll(writeCommands.data(), writeCommands.size(), writeEnqueued.data());
+            while (count == 0)
+            {
+                writing = false;
+                // Messages queued before the flag was cleared did not start a chain
+                if (outputs.Empty() || writing.exchange(true))
                 {
-                    break;
+                    FinishOperation();
+                    return;
                 }
-
-                std::string message = outputs.front();
-                outputs.pop();
-                lock.unlock();
-                asio::write(serial, asio::buffer(message));
+                count = outputs.TryPopAll(writeCommands.data(), writeCommands.size(), writeEnqueued.data());
             }
+            for (std::size_t i = 0; i < count; i++)
+            {
+                writeBuffers[i] = asio::buffer(writeCommands[i].Data(), writeCommands[i].Size());
+            }
+            RecordSendLatency(writeEnqueued.data(), count);
+            BufferSequence buffers{ writeBuffers.data(), writeBuffers.data() + count };
+            asio::async_write(serial, buffers, strand.wrap([this](const asio::error_code& ec, std::size_t)
+            {
+                if (!!ec)
+                {
+                    // The port is gone, the read chain reports it
+                    writing = false;
+                    FinishOperation();
+                    return;
+                }
+                WriteNext();
+            }));
         }
 	};
 
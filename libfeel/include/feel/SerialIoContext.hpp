@@ -0,0 +1,60 @@
+#pragma once
+#define ASIO_STANDALONE
+#include "asio.hpp"
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace feel
+{
+    /// @brief The threads SerialDevice instances do their I/O on
+    ///
+    /// Every SerialDevice creates its own context with one thread by default.
+    /// When driving several gloves, create one context and pass it to all
+    /// devices, so they share a few threads instead of one each.
+    /// The context must outlive the devices using it.
+    class SerialIoContext
+    {
+    public:
+        explicit SerialIoContext(std::size_t threadCount = 1) :
+            work(new asio::io_service::work(service))
+        {
+            for (std::size_t i = 0; i < threadCount; i++)
+            {
+                threads.emplace_back([this]()
+                {
+                    service.run();
+                });
+            }
+        }
+
+        SerialIoContext(const SerialIoContext&) = delete;
+        SerialIoContext& operator=(const SerialIoContext&) = delete;
+
+        ~SerialIoContext()
+        {
+            // Let the threads return once all pending handlers ran
+            work.reset();
+            for (std::thread& thread : threads)
+            {
+                thread.join();
+            }
+        }
+
+        asio::io_service& Service()
+        {
+            return service;
+        }
+
+        std::size_t ThreadCount() const
+        {
+            return threads.size();
+        }
+
+    private:
+        asio::io_service service;
+        std::unique_ptr<asio::io_service::work> work;
+        std::vector<std::thread> threads;
+    };
+}
@@ -0,0 +1,286 @@
+#pragma once
+#include "feel/FrameState.hpp"
+#include "feel/SeqLock.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace feel
+{
+    /// @brief The layout of the shared memory segment
+    ///
+    /// A 16 byte header, the magic "FEELSHM", a version byte and the size of
+    /// FrameState, followed by a SeqLock<FrameState>. The magic is written last,
+    /// readers ignore the segment until it is there.
+    namespace sharedframe
+    {
+        static constexpr char MAGIC[7] = { 'F', 'E', 'E', 'L', 'S', 'H', 'M' };
+        static constexpr std::uint8_t VERSION = 1;
+
+        struct Segment
+        {
+            std::atomic<std::uint64_t> magic;
+            std::uint32_t stateSize;
+            std::uint32_t reserved;
+            SeqLock<FrameState> state;
+        };
+
+        inline std::uint64_t Magic()
+        {
+            std::uint64_t magic = 0;
+            std::memcpy(&magic, MAGIC, sizeof(MAGIC));
+            return magic | (std::uint64_t(VERSION) << 56);
+        }
+
+        /// @brief POSIX names start with a single '/'
+        inline std::string SegmentName(const char* name)
+        {
+#ifdef _WIN32
+            return name;
+#else
+            return name[0] == '/' ? std::string(name) : "/" + std::string(name);
+#endif
+        }
+
+        static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Shared memory needs lock-free 64 bit atomics");
+    }
+
+    /// @brief Publishes frames into a named shared memory segment
+    ///
+    /// Other processes read them with SharedFrameReader, e.g. a recorder
+    /// or a visualizer running next to the game. Publishing never waits for
+    /// readers. The segment is removed when the publisher is closed.
+    class SharedFramePublisher
+    {
+    public:
+        SharedFramePublisher() = default;
+        SharedFramePublisher(const SharedFramePublisher&) = delete;
+        SharedFramePublisher& operator=(const SharedFramePublisher&) = delete;
+
+        ~SharedFramePublisher()
+        {
+            Close();
+        }
+
+        /// @brief Create the segment, replacing one of the same name
+        /// @param name e.g. "feel", without a path
+        /// @return false if it could not be created
+        bool Open(const char* name)
+        {
+            Close();
+            segmentName = sharedframe::SegmentName(name);
+            if (!Map()) return false;
+            segment = new (view) sharedframe::Segment();
+            segment->stateSize = sizeof(FrameState);
+            segment->reserved = 0;
+            segment->magic.store(sharedframe::Magic(), std::memory_order_release);
+            return true;
+        }
+
+        void Close()
+        {
+            if (segment == nullptr) return;
+            segment->magic.store(0, std::memory_order_release);
+            segment->~Segment();
+            segment = nullptr;
+            Unmap();
+        }
+
+        bool IsOpen() const
+        {
+            return segment != nullptr;
+        }
+
+        void Publish(const FrameState& state)
+        {
+            if (segment != nullptr) segment->state.Store(state);
+        }
+
+    private:
+        std::string segmentName;
+        void* view = nullptr;
+        sharedframe::Segment* segment = nullptr;
+#ifdef _WIN32
+        HANDLE mappingHandle = NULL;
+
+        bool Map()
+        {
+            mappingHandle = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, 0, static_cast<DWORD>(sizeof(sharedframe::Segment)), segmentName.c_str());
+            view = mappingHandle == NULL ? nullptr : MapViewOfFile(mappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(sharedframe::Segment));
+            if (view == nullptr)
+            {
+                Unmap();
+                return false;
+            }
+            return true;
+        }
+
+        void Unmap()
+        {
+            if (view != nullptr) UnmapViewOfFile(view);
+            if (mappingHandle != NULL) CloseHandle(mappingHandle);
+            view = nullptr;
+            mappingHandle = NULL;
+        }
+#else
+        bool Map()
+        {
+            int descriptor = shm_open(segmentName.c_str(), O_CREAT | O_RDWR, 0644);
+            if (descriptor < 0) return false;
+            if (ftruncate(descriptor, sizeof(sharedframe::Segment)) != 0)
+            {
+                close(descriptor);
+                shm_unlink(segmentName.c_str());
+                return false;
+            }
+            void* mapped = mmap(nullptr, sizeof(sharedframe::Segment), PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+            close(descriptor);
+            if (mapped == MAP_FAILED)
+            {
+                shm_unlink(segmentName.c_str());
+                return false;
+            }
+            view = mapped;
+            return true;
+        }
+
+        void Unmap()
+        {
+            if (view != nullptr) munmap(view, sizeof(sharedframe::Segment));
+            shm_unlink(segmentName.c_str());
+            view = nullptr;
+        }
+#endif
+    };
+
+    /// @brief Reads the frames of a SharedFramePublisher in another process
+    ///
+    /// Reading is wait-free and never blocks the publisher, the reader only
+    /// maps the segment read-only.
+    class SharedFrameReader
+    {
+    public:
+        SharedFrameReader() = default;
+        SharedFrameReader(const SharedFrameReader&) = delete;
+        SharedFrameReader& operator=(const SharedFrameReader&) = delete;
+
+        ~SharedFrameReader()
+        {
+            Close();
+        }
+
+        /// @brief Attach to the segment of a publisher
+        /// @return false if there is none or it has a different layout
+        bool Open(const char* name)
+        {
+            Close();
+            if (!Map(sharedframe::SegmentName(name))) return false;
+            segment = static_cast<const sharedframe::Segment*>(view);
+            if (segment->magic.load(std::memory_order_acquire) != sharedframe::Magic() || segment->stateSize != sizeof(FrameState))
+            {
+                Close();
+                return false;
+            }
+            return true;
+        }
+
+        void Close()
+        {
+            segment = nullptr;
+            Unmap();
+        }
+
+        bool IsOpen() const
+        {
+            return segment != nullptr;
+        }
+
+        /// @brief Whether the publisher is still there, false after it was closed
+        bool IsPublishing() const
+        {
+            return segment != nullptr && segment->magic.load(std::memory_order_acquire) == sharedframe::Magic();
+        }
+
+        /// @brief Make a single attempt to take a consistent snapshot, wait-free
+        /// @return false if the publisher was writing, state is unchanged then
+        bool TryRead(FrameState& state) const
+        {
+            return segment != nullptr && segment->state.TryLoad(state);
+        }
+
+        /// @brief Take a consistent snapshot, see SeqLock::Load()
+        bool Read(FrameState& state) const
+        {
+            return segment != nullptr && segment->state.Load(state);
+        }
+
+        /// @brief Changes with every published frame, compare it to skip unchanged frames
+        std::uint64_t Version() const
+        {
+            return segment != nullptr ? segment->state.Version() : 0;
+        }
+
+    private:
+        const void* view = nullptr;
+        const sharedframe::Segment* segment = nullptr;
+#ifdef _WIN32
+        HANDLE mappingHandle = NULL;
+
+        bool Map(const std::string& segmentName)
+        {
+            mappingHandle = OpenFileMappingA(FILE_MAP_READ, FALSE, segmentName.c_str());
+            view = mappingHandle == NULL ? nullptr : MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, sizeof(sharedframe::Segment));
+            if (view == nullptr)
+            {
+                Unmap();
+                return false;
+            }
+            return true;
+        }
+
+        void Unmap()
+        {
+            if (view != nullptr) UnmapViewOfFile(view);
+            if (mappingHandle != NULL) CloseHandle(mappingHandle);
+            view = nullptr;
+            mappingHandle = NULL;
+        }
+#else
+        bool Map(const std::string& segmentName)
+        {
+            int descriptor = shm_open(segmentName.c_str(), O_RDONLY, 0);
+            if (descriptor < 0) return false;
+            struct stat info;
+            if (fstat(descriptor, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(sharedframe::Segment))
+            {
+                close(descriptor);
+                return false;
+            }
+            void* mapped = mmap(nullptr, sizeof(sharedframe::Segment), PROT_READ, MAP_SHARED, descriptor, 0);
+            close(descriptor);
+            if (mapped == MAP_FAILED) return false;
+            view = mapped;
+            return true;
+        }
+
+        void Unmap()
+        {
+            if (view != nullptr) munmap(const_cast<void*>(view), sizeof(sharedframe::Segment));
+            view = nullptr;
+        }
+#endif
+    };
+}
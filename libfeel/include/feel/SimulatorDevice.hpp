@@ -2,11 +2,16 @@
 #include "feel/Device.hpp"
 #include "feel/Finger.hpp"
 #include "feel/CalibrationData.hpp"
+#include "feel/NormalizationSweep.hpp"
+#include "feel/MessageFields.hpp"
+#include "feel/RingBuffer.hpp"
+#include "feel/MessageQueue.hpp"
+#include "feel/ReceiveListener.hpp"
 #include <thread>
 #include <mutex>
-#include <queue>
 #include <chrono>
 #include <array>
+#include <cstdio>
 #include <iomanip>
 #include <string>
 #include <sstream>
@@ -14,22 +19,63 @@
 
 namespace feel
 {
+    /// @brief How the time of a SimulatorDevice advances
+    enum class SimulationMode
+    {
+        /// @brief Ticks are scheduled against the wall clock
+        RealTime,
+        /// @brief Nothing happens until SimulatorDevice::Step() is called
+        Stepped,
+        /// @brief Ticks run back to back as fast as the messages are consumed
+        FreeRunning
+    };
+
+    struct SimulatorSettings
+    {
+        SimulationMode mode = SimulationMode::RealTime;
+        /// @brief Ticks per second, every tick sends one update per finger.
+        /// Values of 0 or less fall back to the default.
+        int tickRate = 60;
+        /// @brief Send the normalization as one "NB" message per finger
+        /// instead of one "NI" message per angle
+        bool bulkNormalization = true;
+    };
+
+    /// @brief A device simulating a glove, no hardware needed
+    ///
+    /// Outside of SimulationMode::RealTime the messages are timestamped with
+    /// a virtual clock advancing exactly 1 / tickRate per tick, starting
+    /// when Connect() is called. Such runs are deterministic, but latencies
+    /// measured against the real clock are meaningless.
     class SimulatorDevice : public Device
     {
     public:
 
-        SimulatorDevice() :
-            status(DeviceStatus::Disconnected)
+        SimulatorDevice(SimulatorSettings settings = SimulatorSettings()) :
+            status(DeviceStatus::Disconnected),
+            settings(Validated(settings)),
+            period(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / this->settings.tickRate))),
+            running(false),
+            tickCount(0)
         {
+            calibrationData.angles =
+            {
+                FingerCalibrationData{ 0, 180 },
+                FingerCalibrationData{ 64, 400 },
+                FingerCalibrationData{ 40, 270 },
+                FingerCalibrationData{ 20, 109 },
+                FingerCalibrationData{ 180, 337 },
+                FingerCalibrationData{ 222, 542 },
+                FingerCalibrationData{ 50, 390 },
+                FingerCalibrationData{ 620, 820 },
+                FingerCalibrationData{ 111, 424 },
+                FingerCalibrationData{ 0, 111 }
+            };
         }
 
         ~SimulatorDevice()
         {
-            if (messageGenerator.joinable())
-            {
-                threadFlag.clear();
-                messageGenerator.join();
-            }
+            StopGenerator();
         }
 
         DeviceStatus GetStatus() override
@@ -37,19 +83,49 @@ namespace feel
             return status;
         }
 
-        void Connect(const char* deviceName) override
+        void Connect(const char* /*deviceName*/) override
         {
+            if (status != DeviceStatus::Disconnected) return;
             status = DeviceStatus::Connecting;
-            threadFlag.test_and_set();
-            messageGenerator = std::thread(&SimulatorDevice::MessageGenerator, this);
+            epoch = std::chrono::steady_clock::now();
+            tickCount = 0;
+            if (settings.mode != SimulationMode::Stepped)
+            {
+                running = true;
+                messageGenerator = std::thread(&SimulatorDevice::MessageGenerator, this);
+            }
             status = DeviceStatus::Connected;
         }
 
         void Disconnect()
         {
             status = DeviceStatus::Disconnected;
-            threadFlag.clear();
-            messageGenerator.join();
+            StopGenerator();
+        }
+
+        /// @brief Run ticks on the calling thread
+        ///
+        /// Only does something in SimulationMode::Stepped while connected.
+        /// Messages that do not fit into the input queue are dropped,
+        /// so consume them at least every few hundred ticks.
+        void Step(std::size_t ticks = 1)
+        {
+            if (settings.mode != SimulationMode::Stepped || status != DeviceStatus::Connected) return;
+            for (std::size_t i = 0; i < ticks; i++)
+            {
+                Tick();
+            }
+        }
+
+        /// @brief The number of ticks simulated since Connect()
+        std::uint64_t GetTickCount() const
+        {
+            return tickCount;
+        }
+
+        std::string GetDeviceIdentifier() override
+        {
+            return "Simulator";
         }
 
         void GetAvailableDevices(std::vector<std::string>& devices)
@@ -58,19 +134,56 @@ namespace feel
         }
 
         void TransmitMessage(std::string identifier, std::string payload = "") override
+        {
+            CommandBuffer command;
+            if (!command.Assign(identifier.data(), identifier.size(), payload.data(), payload.size())) return;
+            TransmitMessage(command);
+        }
+
+        void TransmitMessage(const CommandBuffer& command) override
         {
             std::lock_guard<std::mutex> lock(outputMutex);
-            outputs.emplace(identifier + payload);
+            outputs.TryPush(command);
+        }
+
+        void TransmitMessages(const CommandBuffer* commands, std::size_t count) override
+        {
+            std::lock_guard<std::mutex> lock(outputMutex);
+            outputs.TryPush(commands, count);
         }
 
         void IterateAllMessages(std::function<void(const std::string&)> callback) override
         {
-            std::lock_guard<std::mutex> lock(inputMutex);
-            while (!inputs.empty())
+            inputs.Drain([&](const ReceivedMessage& message)
             {
-                callback(inputs.front());
-                inputs.pop();
-            }
+                inputMessage.assign(message.data, message.length);
+                callback(inputMessage);
+            });
+        }
+
+        void IterateReceivedMessages(std::function<void(const ReceivedMessage&)> callback) override
+        {
+            inputs.Drain(callback);
+        }
+
+        void DrainMessages(MessageBatch& batch) override
+        {
+            batch.Clear();
+            inputs.DrainInto(batch);
+        }
+
+        bool SetReceiveListener(std::function<void()> listener) override
+        {
+            receiveListener.Set(listener);
+            return true;
+        }
+
+        DeviceStatistics GetStatistics() override
+        {
+            DeviceStatistics statistics;
+            statistics.inputOverflows = inputs.OverflowCount();
+            statistics.outputOverflows = outputs.OverflowCount();
+            return statistics;
         }
 
         void SetFingerPosition(Finger finger, int angle, int resistance)
@@ -96,13 +209,33 @@ namespace feel
             int resistance = 0;
         };
 
-        DeviceStatus status;
-        std::queue<std::string> inputs;
-        std::queue<std::string> outputs;
-        std::thread messageGenerator;
-        std::mutex inputMutex;
+        static SimulatorSettings Validated(SimulatorSettings settings)
+        {
+            if (settings.tickRate <= 0)
+            {
+                settings.tickRate = SimulatorSettings().tickRate;
+            }
+            return settings;
+        }
+
+        // Virtual clocks that got this far ahead of the consumer wait for it
+        static constexpr std::size_t FREE_RUNNING_BACKLOG = MessageQueue::CAPACITY / 2;
+
+        std::atomic<DeviceStatus> status;
+        const SimulatorSettings settings;
+        const std::chrono::steady_clock::duration period;
+        MessageQueue inputs;
+        ReceiveListener receiveListener;
+        RingBuffer<CommandBuffer, 256> outputs;
+        // The ring has a single producer, but any thread may transmit
         std::mutex outputMutex;
-        std::atomic_flag threadFlag;
+        std::string inputMessage;
+        std::thread messageGenerator;
+        std::atomic<bool> running;
+        std::atomic<std::uint64_t> tickCount;
+        std::chrono::steady_clock::time_point epoch;
+        // The time the messages of the current tick are stamped with
+        std::chrono::steady_clock::time_point tickTime;
         std::array<FingerPositionData, FINGER_TYPE_COUNT> fingerPositions;
         std::mutex fingerMutex;
 
@@ -111,40 +244,69 @@ namespace feel
         
         std::array<FingerOperationStatus, FINGER_TYPE_COUNT> fingerStatus;
         CalibrationData calibrationData;
-        const int frameRate = 60;
 
-        void MessageGenerator()
+        void StopGenerator()
         {
-            calibrationData.angles =
+            running = false;
+            if (messageGenerator.joinable())
             {
-                FingerCalibrationData{ 0, 180 },
-                FingerCalibrationData{ 64, 400 },
-                FingerCalibrationData{ 40, 270 },
-                FingerCalibrationData{ 20, 109 },
-                FingerCalibrationData{ 180, 337 },
-                FingerCalibrationData{ 222, 542 },
-                FingerCalibrationData{ 50, 390 },
-                FingerCalibrationData{ 620, 820 },
-                FingerCalibrationData{ 111, 424 },
-                FingerCalibrationData{ 0, 111 }
-            };
-            while (threadFlag.test_and_set())
+                messageGenerator.join();
+            }
+        }
+
+        void MessageGenerator()
+        {
+            // Sleeping until absolute deadlines keeps the rate exact,
+            // a relative sleep would add the time of every tick.
+            auto deadline = std::chrono::steady_clock::now();
+            while (running)
             {
-                if (inNormalization)
+                if (settings.mode == SimulationMode::FreeRunning)
                 {
-                    std::lock_guard<std::mutex> lock(inputMutex);
-                    inputs.emplace("EN");
-                    inNormalization = false;
+                    // Never get ahead of the consumer so far that messages are dropped
+                    while (inputs.Free() < FREE_RUNNING_BACKLOG && running)
+                    {
+                        std::this_thread::sleep_for(std::chrono::microseconds(100));
+                    }
+                    Tick();
+                    continue;
                 }
-                ParseMessages();
 
-                if (inSession)
+                Tick();
+                deadline += period;
+                auto now = std::chrono::steady_clock::now();
+                if (now - deadline > std::chrono::milliseconds(100))
                 {
-                    std::array<float, FINGER_TYPE_COUNT> angles;                
-                    SimulateFingers(angles);
-                    SendFingerUpdates(angles);
+                    // Far behind (e.g. suspended), continue from now instead of catching up
+                    deadline = now;
                 }
-                std::this_thread::sleep_for(std::chrono::milliseconds(1000/frameRate));
+                std::this_thread::sleep_until(deadline);
+            }
+        }
+
+        void Tick()
+        {
+            tickTime = settings.mode == SimulationMode::RealTime
+                ? std::chrono::steady_clock::now()
+                : epoch + period * static_cast<std::chrono::steady_clock::rep>(tickCount.load());
+            tickCount++;
+
+            if (inNormalization)
+            {
+                PushInput("EN");
+                inNormalization = false;
+            }
+            ParseMessages();
+
+            if (inSession)
+            {
+                std::array<float, FINGER_TYPE_COUNT> angles;
+                SimulateFingers(angles);
+                SendFingerUpdates(angles);
+            }
+            if (!inputs.Empty())
+            {
+                receiveListener.Notify();
             }
         }
 
@@ -157,10 +319,10 @@ namespace feel
 
         void ParseMessages()
         {
-            std::lock_guard<std::mutex> lock(outputMutex);
-            while (!outputs.empty())
+            CommandBuffer command;
+            while (outputs.TryPop(command))
             {
-                std::string& message = outputs.front();
+                std::string message(command.Data(), command.MessageSize());
 
                 auto messageIdentifier = message.substr(0, 2);
                 if (messageIdentifier == "IN")
@@ -168,10 +330,14 @@ namespace feel
                     inNormalization = true;
                     inSession = false;
 
-                    std::lock_guard<std::mutex> lock(inputMutex);
                     for (int i = 0; i < feel::FINGER_TYPE_COUNT; i++)
                     {
                         auto data = calibrationData.angles[i];
+                        if (settings.bulkNormalization)
+                        {
+                            SendNormalizationSweep(i, data);
+                            continue;
+                        }
                         for (int a = 0; a <= 180; a++)
                         {
                             std::stringstream stream;
@@ -182,7 +348,7 @@ namespace feel
                                 << std::dec << std::setw(3)
                                 << a
                                 << (int)std::round(a / 180.0f * (data.max - data.min) + data.min);
-                            inputs.emplace(stream.str());
+                            PushInput(stream.str());
                         }
                     }
                 }
@@ -197,25 +363,39 @@ namespace feel
                 }
                 else if (messageIdentifier == "WF")
                 {
-                    int fingerIndex = std::stoul(message.substr(2, 2), nullptr, 16);
+                    MessageFields fields(message.data(), message.size());
+                    int fingerIndex = fields.Finger();
+                    int force = fields.Decimal(2);
+                    int angle = fields.Decimal();
+                    if (fields.Error() != FrameError::None)
+                    {
+                        PushInput("DLMalformed Message: " + message);
+                        continue;
+                    }
                     FingerOperationStatus& status = fingerStatus[fingerIndex];
                     status.on = true;
-                    status.targetForce = 99 - std::stoi(message.substr(4, 2));
-                    status.targetAngle = std::stoi(message.substr(6));
+                    status.targetForce = 99 - force;
+                    status.targetAngle = angle;
+                }
+                else if (messageIdentifier == "PI")
+                {
+                    PushInput("PO" + message.substr(2));
                 }
                 else if (messageIdentifier == "RE")
                 {
-                    int fingerIndex = std::stoul(message.substr(2, 2), nullptr, 16);
-                    FingerOperationStatus& status = fingerStatus[fingerIndex];
-                    status.on = false;
+                    MessageFields fields(message.data(), message.size());
+                    int fingerIndex = fields.Finger();
+                    if (fields.Error() != FrameError::None)
+                    {
+                        PushInput("DLMalformed Message: " + message);
+                        continue;
+                    }
+                    fingerStatus[fingerIndex].on = false;
                 }
                 else
                 {
-                    std::lock_guard<std::mutex> lock(inputMutex);
-                    inputs.emplace("DLUnknown Message: " + message);
+                    PushInput("DLUnknown Message: " + message);
                 }
-
-                outputs.pop();
             }
         }
 
@@ -239,28 +419,46 @@ namespace feel
                 else
                 {
                     float forceFactor = std::max(0, std::max(status.targetForce, 1) - pos.resistance);
-                    pos.angle += forceFactor / frameRate * (pos.angle - status.targetAngle > 0 ? -1 : 1);
+                    pos.angle += forceFactor / settings.tickRate * (pos.angle - status.targetAngle > 0 ? -1 : 1);
                 }
 
                 angles[i] = pos.angle;
             }
         }
 
+        void SendNormalizationSweep(int fingerIndex, const FingerCalibrationData& data)
+        {
+            std::array<int, 181> angles;
+            for (int a = 0; a <= 180; a++)
+            {
+                angles[a] = (int)std::round(a / 180.0f * (data.max - data.min) + data.min);
+            }
+            char message[NormalizationSweep::HEADER_SIZE + 181 * NormalizationSweep::SAMPLE_WIDTH];
+            std::size_t length = NormalizationSweep::Encode(fingerIndex, 0, angles.data(), angles.size(), message);
+            PushInput(message, length);
+        }
+
         void SendFingerUpdates(const std::array<float, FINGER_TYPE_COUNT>& angles)
         {
-            std::lock_guard<std::mutex> lock(inputMutex);
             for (int i = 0; i < feel::FINGER_TYPE_COUNT; i++)
             {
                 const FingerCalibrationData& data = calibrationData.angles[i];
-                std::stringstream stream;
-                stream
-                    << "UF"
-                    << std::setfill('0') << std::setw(2)
-                    << std::hex << i
-                    << std::setw(3)
-                    << std::dec << (int) std::round(angles[i] / 180 * (data.max - data.min) + data.min);
-                inputs.emplace(stream.str());
+                int angle = (int) std::round(angles[i] / 180 * (data.max - data.min) + data.min);
+                // Formatted into a local buffer, at high tick rates this runs millions of times
+                char message[16];
+                int length = std::snprintf(message, sizeof(message), "UF%02x%03d", i, angle);
+                PushInput(message, length);
             }
         }
+
+        void PushInput(const std::string& message)
+        {
+            PushInput(message.data(), message.size());
+        }
+
+        void PushInput(const char* message, std::size_t length)
+        {
+            inputs.TryPush(message, length, tickTime);
+        }
     };
 }
\ No newline at end of file
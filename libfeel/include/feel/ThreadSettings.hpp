@@ -0,0 +1,74 @@
+#pragma once
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace feel
+{
+    enum class ThreadPriority
+    {
+        /// @brief The priority the thread was created with
+        Normal,
+        /// @brief Above the other threads of the application
+        High,
+        /// @brief Above almost everything else, use with care.
+        /// On POSIX both High and TimeCritical use SCHED_FIFO,
+        /// which usually needs elevated permissions.
+        TimeCritical
+    };
+
+    /// @brief Where and how urgently a thread of the library runs
+    struct ThreadSettings
+    {
+        /// @brief The CPU the thread is pinned to, -1 to let the system choose
+        ///
+        /// Pinning is supported on Windows and Linux.
+        int cpu = -1;
+        ThreadPriority priority = ThreadPriority::Normal;
+
+        /// @brief Apply the settings to the calling thread
+        /// @return false if a setting could not be applied, e.g. for lack of permissions
+        bool ApplyToCurrentThread() const
+        {
+            bool applied = true;
+#ifdef _WIN32
+            if (cpu >= 0)
+            {
+                applied = cpu < 64 && SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+            }
+            if (priority != ThreadPriority::Normal)
+            {
+                int level = priority == ThreadPriority::High ? THREAD_PRIORITY_HIGHEST : THREAD_PRIORITY_TIME_CRITICAL;
+                if (!SetThreadPriority(GetCurrentThread(), level)) applied = false;
+            }
+#else
+#ifdef __linux__
+            if (cpu >= 0)
+            {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+                applied = cpu < CPU_SETSIZE && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+            }
+#else
+            if (cpu >= 0) applied = false;
+#endif
+            if (priority != ThreadPriority::Normal)
+            {
+                int lowest = sched_get_priority_min(SCHED_FIFO);
+                int highest = sched_get_priority_max(SCHED_FIFO);
+                sched_param parameters = {};
+                parameters.sched_priority = priority == ThreadPriority::High ? lowest + (highest - lowest) / 4 : highest - 1;
+                if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters) != 0) applied = false;
+            }
+#endif
+            return applied;
+        }
+    };
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <stdint.h>
+
+/* The C API of libfeelc, for C and for managed code (P/Invoke etc.).
+ *
+ * The structs below are exchanged by pointer, their layout is part of the
+ * ABI and does not change: all fields are little endian and naturally
+ * aligned, there is no hidden padding. In C# they map to
+ * [StructLayout(LayoutKind.Sequential)] structs with the same fields. */
+
+#ifndef FEEL_API
+#ifdef _WIN32
+#define FEEL_API __declspec(dllimport)
+#else
+#define FEEL_API
+#endif
+#endif
+
+#ifdef __cplusplus
+namespace feel
+{
+    class Feel;
+    class Device;
+}
+typedef feel::Feel FeelInstance;
+typedef feel::Device FeelDevice;
+extern "C"
+{
+#else
+typedef struct FeelInstance FeelInstance;
+typedef struct FeelDevice FeelDevice;
+#endif
+
+typedef intptr_t FeelStringArrayHandle;
+
+#define FEEL_LATENCY_BUCKET_COUNT 32
+
+/* Filled by FEEL_GetLatencyHistogram, 280 bytes, see feel::LatencyHistogramData.
+ * Bucket 0 counts latencies below 1 microsecond, bucket i those from
+ * 2^(i-1) up to 2^i microseconds, the last one also everything above. */
+struct FeelLatencyHistogram
+{
+    uint64_t buckets[FEEL_LATENCY_BUCKET_COUNT]; /* offset 0 */
+    uint64_t count;                              /* offset 256 */
+    uint64_t totalMicroseconds;                  /* offset 264 */
+    uint64_t maxMicroseconds;                    /* offset 272 */
+};
+
+/* Used by FEEL_SetFingerTargets, 16 bytes */
+struct FeelFingerTarget
+{
+    int32_t finger;  /* offset 0, see feel::Finger */
+    float angle;     /* offset 4, 0 - 180 */
+    int32_t force;   /* offset 8, 0 - 99 */
+    int32_t release; /* offset 12, non-zero releases the finger, angle and force are ignored then */
+};
+
+/* Filled by FEEL_GetStatusInfo, 64 bytes */
+struct FeelStatusInfo
+{
+    int32_t status;                    /* offset 0, see feel::FeelStatus */
+    int32_t reserved;                  /* offset 4 */
+    uint64_t inputOverflows;           /* offset 8, see feel::DeviceStatistics */
+    uint64_t outputOverflows;          /* offset 16 */
+    uint64_t coalescedOutputs;         /* offset 24 */
+    uint64_t unknownMessages;          /* offset 32, see feel::Feel::GetUnknownMessageCount */
+    uint64_t rejectedTruncated;        /* offset 40, see feel::RejectedFrameCounts */
+    uint64_t rejectedInvalidNumber;    /* offset 48 */
+    uint64_t rejectedFingerOutOfRange; /* offset 56 */
+};
+
+typedef struct FeelLatencyHistogram FeelLatencyHistogram;
+typedef struct FeelFingerTarget FeelFingerTarget;
+typedef struct FeelStatusInfo FeelStatusInfo;
+
+FEEL_API FeelInstance* FEEL_CreateNewWithDevice(FeelDevice* device);
+FEEL_API FeelInstance* FEEL_CreateWithSerialDevice(void);
+FEEL_API FeelInstance* FEEL_CreateWithSimulatorDevice(void);
+FEEL_API void FEEL_Destroy(FeelInstance* feel);
+
+FEEL_API void FEEL_Connect(FeelInstance* feel, const char* deviceName);
+FEEL_API void FEEL_Disconnect(FeelInstance* feel);
+/* Release the names with FEEL_ReleaseFeelStringArrayHandle */
+FEEL_API void FEEL_GetAvailableDevices(FeelInstance* feel, FeelStringArrayHandle* handle, char*** devices, int* deviceCount);
+FEEL_API void FEEL_ReleaseFeelStringArrayHandle(FeelStringArrayHandle* handle);
+
+FEEL_API void FEEL_StartNormalization(FeelInstance* feel);
+FEEL_API void FEEL_BeginSession(FeelInstance* feel);
+FEEL_API void FEEL_EndSession(FeelInstance* feel);
+FEEL_API void FEEL_ParseMessages(FeelInstance* feel);
+
+FEEL_API void FEEL_SetFingerAngle(FeelInstance* feel, int finger, float angle, int force);
+FEEL_API void FEEL_ReleaseFinger(FeelInstance* feel, int finger);
+FEEL_API float FEEL_GetFingerAngle(FeelInstance* feel, int finger);
+/* See feel::FeelStatus */
+FEEL_API int FEEL_GetStatus(FeelInstance* feel);
+
+FEEL_API int FEEL_GetFingerCount(void);
+/* Writes the angles of the first count fingers (at most FEEL_GetFingerCount()), returns how many */
+FEEL_API int FEEL_GetFingerAngles(FeelInstance* feel, float* angles, int count);
+/* Writes the velocities in degrees per second, like FEEL_GetFingerAngles */
+FEEL_API int FEEL_GetFingerVelocities(FeelInstance* feel, float* velocities, int count);
+/* Moves or releases several fingers with one batch of commands, targets with an invalid finger are skipped */
+FEEL_API void FEEL_SetFingerTargets(FeelInstance* feel, const FeelFingerTarget* targets, int count);
+FEEL_API void FEEL_GetStatusInfo(FeelInstance* feel, FeelStatusInfo* info);
+
+FEEL_API void FEEL_SetDebugLogCallback(FeelInstance* feel, void (*callback)(const char*));
+/* level: 0 = trace ... 4 = error, 5 = off (see feel::LogLevel) */
+FEEL_API void FEEL_SetLogLevel(int level);
+
+FEEL_API void FEEL_SetInstrumentation(FeelInstance* feel, int enabled);
+FEEL_API int FEEL_SendLatencyProbe(FeelInstance* feel);
+/* stage: 0 = send, 1 = consume, 2 = round trip (see feel::LatencyStage) */
+FEEL_API void FEEL_GetLatencyHistogram(FeelInstance* feel, int stage, FeelLatencyHistogram* histogram);
+
+/* Sets the calibration data stored for the connected glove, returns 1 if there was any */
+FEEL_API int FEEL_LoadCalibration(FeelInstance* feel, const char* fileName);
+/* Stores the calibration data of the connected glove, keeps the ones of other gloves */
+FEEL_API int FEEL_SaveCalibration(FeelInstance* feel, const char* fileName);
+/* 0 = pending, 1 = valid, 2 = invalid (see feel::CalibrationCheck) */
+FEEL_API int FEEL_CheckCalibration(FeelInstance* feel);
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,17 +4,32 @@
 #define FEEL_API
 #endif
 #include "feel.hpp"
+#include "feel_c.h"
 #include <memory>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+
 
 extern "C"
 {
-    typedef intptr_t FeelStringArrayHandle;
     struct FeelStringArray
     {
         char** strings;
         int size;
     };
 
+    // The layouts of feel_c.h are part of the ABI and must not change
+    static_assert(FEEL_LATENCY_BUCKET_COUNT == feel::LatencyHistogramData::BUCKET_COUNT, "FeelLatencyHistogram must match feel::LatencyHistogramData");
+    static_assert(sizeof(FeelLatencyHistogram) == 280, "FeelLatencyHistogram layout changed");
+    static_assert(sizeof(float) == 4, "float must be 32 bit");
+    static_assert(sizeof(FeelFingerTarget) == 16, "FeelFingerTarget layout changed");
+    static_assert(offsetof(FeelFingerTarget, angle) == 4 && offsetof(FeelFingerTarget, force) == 8 && offsetof(FeelFingerTarget, release) == 12, "FeelFingerTarget layout changed");
+    static_assert(sizeof(FeelStatusInfo) == 64, "FeelStatusInfo layout changed");
+    static_assert(offsetof(FeelStatusInfo, inputOverflows) == 8 && offsetof(FeelStatusInfo, rejectedFingerOutOfRange) == 56, "FeelStatusInfo layout changed");
+
     FEEL_API feel::Feel* FEEL_CreateNewWithDevice(feel::Device* device)
     {
         return new feel::Feel(device);
@@ -22,7 +37,11 @@ extern "C"
 
 	FEEL_API feel::Feel* FEEL_CreateWithSerialDevice()
 	{
+#ifdef _WIN32
         return new feel::Feel(new feel::SerialDevice());
+#else
+        return new feel::Feel(new feel::PosixSerialDevice());
+#endif
 	}
 
     FEEL_API feel::Feel* FEEL_CreateWithSimulatorDevice()
@@ -107,6 +126,65 @@ extern "C"
         return feel->GetStatus();
     }
 
+    FEEL_API int FEEL_GetFingerCount()
+    {
+        return feel::FINGER_TYPE_COUNT;
+    }
+
+    // Writes the angles of the first count fingers (at most FEEL_GetFingerCount()), returns how many
+    FEEL_API int FEEL_GetFingerAngles(feel::Feel* feel, float* angles, int count)
+    {
+        if (count <= 0) return 0;
+        return static_cast<int>(feel->GetFingerAngles(angles, static_cast<std::size_t>(count)));
+    }
+
+    // Writes the velocities in degrees per second, like FEEL_GetFingerAngles
+    FEEL_API int FEEL_GetFingerVelocities(feel::Feel* feel, float* velocities, int count)
+    {
+        if (count <= 0) return 0;
+        return static_cast<int>(feel->GetFingerVelocities(velocities, static_cast<std::size_t>(count)));
+    }
+
+    // Moves or releases several fingers with one batch of commands, targets with an invalid finger are skipped
+    FEEL_API void FEEL_SetFingerTargets(feel::Feel* feel, const FeelFingerTarget* targets, int count)
+    {
+        std::array<feel::FingerTarget, feel::FINGER_TYPE_COUNT> converted;
+        std::size_t convertedCount = 0;
+        for (int i = 0; i < count; i++)
+        {
+            const FeelFingerTarget& target = targets[i];
+            if (target.finger < 0 || target.finger >= feel::FINGER_TYPE_COUNT) continue;
+            auto finger = static_cast<feel::Finger>(target.finger);
+            converted[convertedCount++] = target.release != 0
+                ? feel::FingerTarget::Release(finger)
+                : feel::FingerTarget::Move(finger, target.angle, target.force);
+            if (convertedCount == converted.size())
+            {
+                feel->SetFingerTargets(converted.data(), convertedCount);
+                convertedCount = 0;
+            }
+        }
+        if (convertedCount > 0)
+        {
+            feel->SetFingerTargets(converted.data(), convertedCount);
+        }
+    }
+
+    FEEL_API void FEEL_GetStatusInfo(feel::Feel* feel, FeelStatusInfo* info)
+    {
+        feel::DeviceStatistics statistics = feel->GetDeviceStatistics();
+        feel::RejectedFrameCounts rejected = feel->GetRejectedFrameCounts();
+        info->status = static_cast<int32_t>(feel->GetStatus());
+        info->reserved = 0;
+        info->inputOverflows = statistics.inputOverflows;
+        info->outputOverflows = statistics.outputOverflows;
+        info->coalescedOutputs = statistics.coalescedOutputs;
+        info->unknownMessages = feel->GetUnknownMessageCount();
+        info->rejectedTruncated = rejected.truncated;
+        info->rejectedInvalidNumber = rejected.invalidNumber;
+        info->rejectedFingerOutOfRange = rejected.fingerOutOfRange;
+    }
+
 	FEEL_API void FEEL_ParseMessages(feel::Feel* feel)
 	{
 		feel->ParseMessages();
@@ -119,4 +197,55 @@ extern "C"
             callback(s.c_str());
         });
     }
+
+    // level: 0 = trace ... 4 = error, 5 = off (see feel::LogLevel)
+    FEEL_API void FEEL_SetLogLevel(int level)
+    {
+        feel::Logger::Default().SetLevel(static_cast<feel::LogLevel>(level));
+    }
+
+    FEEL_API void FEEL_SetInstrumentation(feel::Feel* feel, int enabled)
+    {
+        feel->SetInstrumentation(enabled != 0);
+    }
+
+    FEEL_API int FEEL_SendLatencyProbe(feel::Feel* feel)
+    {
+        return feel->SendLatencyProbe();
+    }
+
+    // Sets the calibration data stored for the connected glove, returns 1 if there was any
+    FEEL_API int FEEL_LoadCalibration(feel::Feel* feel, const char* fileName)
+    {
+        feel::CalibrationStore store;
+        feel::CalibrationData data;
+        if (!store.Load(fileName) || !store.Find(feel->GetDeviceIdentifier(), data)) return 0;
+        feel->SetCalibrationData(data);
+        return 1;
+    }
+
+    // Stores the calibration data of the connected glove, keeps the ones of other gloves
+    FEEL_API int FEEL_SaveCalibration(feel::Feel* feel, const char* fileName)
+    {
+        feel::CalibrationStore store;
+        store.Load(fileName);
+        if (!store.Store(feel->GetDeviceIdentifier(), feel->GetCalibrationData())) return 0;
+        return store.Save(fileName) ? 1 : 0;
+    }
+
+    // 0 = pending, 1 = valid, 2 = invalid (see feel::CalibrationCheck)
+    FEEL_API int FEEL_CheckCalibration(feel::Feel* feel)
+    {
+        return static_cast<int>(feel->CheckCalibration());
+    }
+
+    // stage: 0 = send, 1 = consume, 2 = round trip (see feel::LatencyStage)
+    FEEL_API void FEEL_GetLatencyHistogram(feel::Feel* feel, int stage, FeelLatencyHistogram* histogram)
+    {
+        feel::LatencyHistogramData data = feel->GetLatencyHistogram(static_cast<feel::LatencyStage>(stage));
+        std::copy(data.buckets.begin(), data.buckets.end(), histogram->buckets);
+        histogram->count = data.count;
+        histogram->totalMicroseconds = data.totalMicroseconds;
+        histogram->maxMicroseconds = data.maxMicroseconds;
+    }
 }
\ No newline at end of file